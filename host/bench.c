@@ -0,0 +1,682 @@
+//
+// bench.c - benchmarks for the game core, hosted (Linux) build only
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+// usage: bench <what> [options], run without arguments for the list
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "batch.h"
+#include "board.h"
+#include "cpu.h"
+#include "eval.h"
+#include "game.h"
+#include "ntuple.h"
+#include "rng.h"
+#include "rollout.h"
+#include "search.h"
+#include "tsc.h"
+
+#define TABLE_SIZE  (1 << 20)
+
+static ntuple_t weights;
+
+static void load_weights(const char* path)
+{
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        perror(path);
+        exit(1);
+    }
+    void* buf = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (buf == MAP_FAILED)
+    {
+        perror(path);
+        exit(1);
+    }
+    int err = ntuple_map(&weights, buf, st.st_size);
+    if (err != NTUPLE_OK)
+    {
+        fprintf(stderr, "%s: %s\n", path, ntuple_strerror(err));
+        exit(1);
+    }
+    eval_set_network(&weights);
+}
+
+struct play_stats_struct
+{
+    uint64_t    moves;
+    uint64_t    nodes;
+    uint64_t    cutoffs;
+    uint64_t    depths;
+    uint64_t    us;
+    uint64_t    score;
+    uint32_t    max_us;
+    uint32_t    over;           // moves that took 10% more than the budget
+    int         max_tiles[16];  // how many games ended with which max tile
+};
+typedef struct play_stats_struct play_stats_t;
+
+// Plays whole games with the search, game g uses stream g of seed
+static void play_games(const search_limits_t* limits, int games, 
+                       uint32_t seed, bool verbose, play_stats_t* stats)
+{
+    search_t search;
+    search_entry_t* table = malloc(TABLE_SIZE * sizeof(search_entry_t));
+    if (table == 0)
+    {
+        perror("malloc");
+        exit(1);
+    }
+    search_init(&search, table, TABLE_SIZE);
+    
+    memset(stats, 0, sizeof(*stats));
+    for (int g = 0; g < games; g++)
+    {
+        game_t game;
+        rng_seed_stream(&game.rng, seed, g);
+        game_reset(&game);
+        while (!game.lost)
+        {
+            search_result_t result;
+            search_run(&search, game.board, limits, &result);
+            if (result.dir < 0)
+                break;
+            game_move(&game, result.dir);
+            stats->moves++;
+            stats->nodes += result.nodes;
+            stats->cutoffs += result.cutoffs;
+            stats->depths += result.depth;
+            stats->us += result.us;
+            if (result.us > stats->max_us)
+                stats->max_us = result.us;
+            if (limits->budget_us && 
+                        result.us > limits->budget_us + limits->budget_us / 10)
+                stats->over++;
+        }
+        stats->score += game.score;
+        stats->max_tiles[board_max_tile(game.board)]++;
+        if (verbose)
+            printf("game %d: score %llu, max tile %d\n", g, 
+                    (unsigned long long) game.score, 
+                    1 << board_max_tile(game.board));
+    }
+    free(table);
+}
+
+static bool search_option(int opt, search_limits_t* limits)
+{
+    switch (opt)
+    {
+        case 'b': limits->budget_us = strtoul(optarg, 0, 0); return true;
+        case 'd': limits->max_depth = atoi(optarg); return true;
+        case 'p': limits->min_prob = atof(optarg); return true;
+        case 'c': limits->sample_cells = atoi(optarg); return true;
+        case 'w': load_weights(optarg); return true;
+        case 'k':
+            for (int k = 0; k < BOARD_KERNEL_COUNT; k++)
+                if (strcmp(optarg, board_kernel_name(k)) == 0 && 
+                                                        board_set_kernel(k))
+                    return true;
+            fprintf(stderr, "kernel %s isn't there\n", optarg);
+            exit(1);
+        default: return false;
+    }
+}
+
+#define SEARCH_OPTIONS  "b:d:p:c:w:k:"
+#define SEARCH_USAGE    "[-b budget_us] [-d max_depth] [-p min_prob] " \
+                        "[-c sample_cells] [-w weights] [-k move kernel]"
+
+// Plays whole games with the time bounded search and looks at how deep it
+// gets and how well it keeps to the budget
+static int bench_search(int argc, char** argv)
+{
+    search_limits_t limits;
+    limits.budget_us = 1000;
+    limits.max_depth = SEARCH_MAX_DEPTH;
+    limits.min_prob = 0;
+    limits.sample_cells = 0;
+    limits.abort = 0;
+    int games = 3;
+    uint32_t seed = 420;
+    
+    int opt;
+    while ((opt = getopt(argc, argv, SEARCH_OPTIONS "g:s:")) != -1)
+    {
+        if (search_option(opt, &limits))
+            continue;
+        switch (opt)
+        {
+            case 'g': games = atoi(optarg); break;
+            case 's': seed = strtoul(optarg, 0, 0); break;
+            default:
+                fprintf(stderr, "usage: %s search " SEARCH_USAGE 
+                                " [-g games] [-s seed]\n", argv[0]);
+                return 1;
+        }
+    }
+    
+    printf("search: budget %u us, max depth %d, min prob %g, "
+           "sample %d cells, %s, %s moves\n", limits.budget_us, 
+           limits.max_depth, limits.min_prob, limits.sample_cells, 
+           eval_has_network() ? "n-tuple" : "heuristic", 
+           board_kernel_name(board_kernel()));
+    
+    play_stats_t stats;
+    play_games(&limits, games, seed, true, &stats);
+    
+    printf("%llu moves, avg score %.0f\n"
+           "avg depth %.2f, avg %.0f nodes/move, %.0f nodes/s, "
+           "%.0f cutoffs/move\n"
+           "avg %.0f us/move, max %u us, %u moves over budget\n", 
+           (unsigned long long) stats.moves, (double) stats.score / games, 
+           (double) stats.depths / stats.moves, 
+           (double) stats.nodes / stats.moves, 
+           stats.nodes / (stats.us / 1e6), 
+           (double) stats.cutoffs / stats.moves,
+           (double) stats.us / stats.moves, stats.max_us, stats.over);
+    return 0;
+}
+
+// Same games, same budget, different probability cutoffs and sampling
+static int bench_prune(int argc, char** argv)
+{
+    search_limits_t base;
+    base.budget_us = 1000;
+    base.max_depth = SEARCH_MAX_DEPTH;
+    base.min_prob = 0;
+    base.sample_cells = 0;
+    base.abort = 0;
+    int games = 3;
+    uint32_t seed = 420;
+    
+    int opt;
+    while ((opt = getopt(argc, argv, SEARCH_OPTIONS "g:s:")) != -1)
+    {
+        if (opt != 'p' && opt != 'c' && search_option(opt, &base))
+            continue;
+        switch (opt)
+        {
+            case 'g': games = atoi(optarg); break;
+            case 's': seed = strtoul(optarg, 0, 0); break;
+            default:
+                fprintf(stderr, "usage: %s prune [-b budget_us] "
+                        "[-d max_depth] [-w weights] [-g games] [-s seed]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+    
+    static const struct
+    {
+        float   min_prob;
+        int     sample_cells;
+    } configs[] = {
+        {0, 0}, {1e-5f, 0}, {1e-4f, 0}, {1e-3f, 0}, {0, 6}, {0, 4}, 
+        {1e-4f, 6},
+    };
+    
+    printf("prune: budget %u us, max depth %d, %d games, %s\n", 
+            base.budget_us, base.max_depth, games, 
+            eval_has_network() ? "n-tuple" : "heuristic");
+    printf("min_prob  sample   avg score  2048 rate  avg depth  "
+           "nodes/move  cutoffs/move\n");
+    for (size_t i = 0; i < sizeof(configs) / sizeof(configs[0]); i++)
+    {
+        search_limits_t limits = base;
+        limits.min_prob = configs[i].min_prob;
+        limits.sample_cells = configs[i].sample_cells;
+        
+        play_stats_t stats;
+        play_games(&limits, games, seed, false, &stats);
+        
+        int wins = 0;
+        for (int t = GAME_WIN_TILE; t < 16; t++)
+            wins += stats.max_tiles[t];
+        printf("%8g  %6d  %10.0f  %8.1f%%  %9.2f  %10.0f  %12.0f\n", 
+                limits.min_prob, limits.sample_cells, 
+                (double) stats.score / games, 100.0 * wins / games, 
+                (double) stats.depths / stats.moves, 
+                (double) stats.nodes / stats.moves, 
+                (double) stats.cutoffs / stats.moves);
+        fflush(stdout);
+    }
+    return 0;
+}
+
+// Raw generator speed, bounded sampling and what it comes down to: spawns
+static int bench_rng(int argc, char** argv)
+{
+    long count = argc > 1 ? atol(argv[1]) : 100000000;
+    rng_t rng;
+    rng_seed(&rng, 420);
+    uint32_t sink = 0;
+    
+    uint64_t start = tsc_read();
+    for (long i = 0; i < count; i++)
+        sink += rng_next(&rng);
+    uint64_t next = tsc_read() - start;
+    
+    start = tsc_read();
+    for (long i = 0; i < count; i++)
+        sink += rng_below(&rng, 150);
+    uint64_t below = tsc_read() - start;
+    
+    static uint32_t buf[4096];
+    start = tsc_read();
+    for (long i = 0; i < count; i += 4096)
+    {
+        rng_fill(&rng, buf, 4096);
+        sink += buf[i & 4095];
+    }
+    uint64_t fill = tsc_read() - start;
+    
+    // a board that gets emptied now and then so spawning never runs out
+    board_t board = 0;
+    start = tsc_read();
+    for (long i = 0; i < count; i++)
+    {
+        board = board_spawn(board, &rng);
+        if ((i & 7) == 7)
+            board = 0;
+    }
+    uint64_t spawn = tsc_read() - start;
+    
+    printf("rng_next    %6.2f ns\n"
+           "rng_below   %6.2f ns\n"
+           "rng_fill    %6.2f ns per value\n"
+           "board_spawn %6.2f ns\n", 
+           tsc_to_us(next) * 1000.0 / count, 
+           tsc_to_us(below) * 1000.0 / count, 
+           tsc_to_us(fill) * 1000.0 / count, 
+           tsc_to_us(spawn) * 1000.0 / count);
+    return (sink ^ (uint32_t) board) == 42;   // so nothing gets optimized out
+}
+
+// Boards from random games, so the rows look like the ones in real play
+static board_t* collect_boards(size_t count, uint32_t seed)
+{
+    board_t* boards = malloc(count * sizeof(board_t));
+    if (boards == 0)
+    {
+        perror("malloc");
+        exit(1);
+    }
+    game_t game;
+    rng_seed(&game.rng, seed);
+    game_reset(&game);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (game.lost)
+            game_reset(&game);
+        boards[i] = game.board;
+        game_move(&game, rng_below(&game.rng, DIR_COUNT));
+    }
+    return boards;
+}
+
+// Every board_move_all kernel the CPU has, with the tables in the cache and
+// with the cache thrown out before every few moves
+static int bench_moves(int argc, char** argv)
+{
+    long count = argc > 1 ? atol(argv[1]) : 10000000;
+    const size_t warm_boards = 4096;
+    const int cold_batch = 16;
+    const int cold_rounds = 2000;
+    const size_t evict_size = 64 << 20;
+    
+    board_t* boards = collect_boards(warm_boards + cold_batch * cold_rounds, 
+                                                                        420);
+    volatile uint8_t* evict = malloc(evict_size);
+    if (evict == 0)
+    {
+        perror("malloc");
+        return 1;
+    }
+    
+    int original = board_kernel();
+    board_t sink = 0;
+    printf("kernel      warm ns   cold ns\n");
+    for (int kernel = 0; kernel < BOARD_KERNEL_COUNT; kernel++)
+    {
+        if (!board_set_kernel(kernel))
+        {
+            printf("%-8s    not supported by this CPU\n", 
+                                                    board_kernel_name(kernel));
+            continue;
+        }
+        
+        board_t after[DIR_COUNT];
+        uint32_t score[DIR_COUNT];
+        uint64_t start = tsc_read();
+        for (long i = 0; i < count; i++)
+        {
+            board_move_all(boards[i & (warm_boards - 1)], after, score);
+            sink ^= after[i & 3] + score[i & 3];
+        }
+        uint64_t warm = tsc_read() - start;
+        
+        uint64_t cold = 0;
+        for (int round = 0; round < cold_rounds; round++)
+        {
+            for (size_t i = 0; i < evict_size; i += 64)
+                evict[i]++;
+            board_t* batch = boards + warm_boards + round * cold_batch;
+            start = tsc_read();
+            for (int i = 0; i < cold_batch; i++)
+            {
+                board_move_all(batch[i], after, score);
+                sink ^= after[i & 3] + score[i & 3];
+            }
+            cold += tsc_read() - start;
+        }
+        
+        printf("%-8s  %9.2f %9.2f\n", board_kernel_name(kernel), 
+                tsc_to_us(warm) * 1000.0 / count, 
+                tsc_to_us(cold) * 1000.0 / (cold_rounds * cold_batch));
+        fflush(stdout);
+    }
+    board_set_kernel(original);
+    
+    free((void*) evict);
+    free(boards);
+    return sink == 42;   // so nothing gets optimized out
+}
+
+// Board-steps per second of the batch engine, against one board_move per
+// board (the scalar kernel)
+static int bench_batch(int argc, char** argv)
+{
+    size_t count = argc > 1 ? strtoul(argv[1], 0, 0) : 4096;
+    int rounds = argc > 2 ? atoi(argv[2]) : 2000;
+    
+    board_t* boards = collect_boards(count, 420);
+    batch_t batch;
+    void* mem;
+    if (posix_memalign(&mem, BATCH_ALIGN, batch_size(count)) != 0)
+    {
+        perror("posix_memalign");
+        return 1;
+    }
+    batch_init(&batch, mem, count);
+    
+    int original = batch_kernel();
+    uint32_t sink = 0;
+    printf("%zu boards, %d rounds\n"
+           "kernel      move Msteps/s   move+spawn Msteps/s\n", count, rounds);
+    for (int kernel = 0; kernel < BATCH_KERNEL_COUNT; kernel++)
+    {
+        if (!batch_set_kernel(kernel))
+        {
+            printf("%-8s    not supported by this CPU\n", 
+                                                    batch_kernel_name(kernel));
+            continue;
+        }
+        
+        for (size_t i = 0; i < count; i++)
+            batch_set(&batch, i, boards[i]);
+        uint64_t start = tsc_read();
+        for (int r = 0; r < rounds; r++)
+        {
+            batch_move(&batch, r & 3);
+            sink += batch.scores[r % count];
+        }
+        uint64_t move = tsc_read() - start;
+        
+        rng_t rng;
+        rng_seed(&rng, 420);
+        for (size_t i = 0; i < count; i++)
+            batch_set(&batch, i, boards[i]);
+        start = tsc_read();
+        for (int r = 0; r < rounds; r++)
+        {
+            batch_move(&batch, r & 3);
+            batch_spawn(&batch, &rng);
+            sink += batch.scores[r % count];
+        }
+        uint64_t both = tsc_read() - start;
+        
+        double steps = (double) count * rounds;
+        printf("%-8s  %15.1f %21.1f\n", batch_kernel_name(kernel), 
+                steps / tsc_to_us(move), steps / tsc_to_us(both));
+        fflush(stdout);
+    }
+    batch_set_kernel(original);
+    
+    free(mem);
+    free(boards);
+    return sink == 42;
+}
+
+// The rollout pool: the main thread puts the board up, every worker does its
+// share of the rollouts into its own sums and the main thread adds them up
+// once they're all past the barrier. Nothing else is shared.
+struct rollout_worker_struct
+{
+    pthread_t       thread;
+    rng_t           rng;
+    uint32_t        count;
+    rollout_sums_t  sums;
+} __attribute__((aligned(64)));     // own cache line, they're written a lot
+typedef struct rollout_worker_struct rollout_worker_t;
+
+static pthread_barrier_t    rollout_start;
+static pthread_barrier_t    rollout_done;
+static rollout_limits_t     rollout_limits;
+static board_t              rollout_board;
+static bool                 rollout_quit;
+
+static void* rollout_thread(void* arg)
+{
+    rollout_worker_t* worker = arg;
+    for (;;)
+    {
+        pthread_barrier_wait(&rollout_start);
+        if (rollout_quit)
+            return 0;
+        rollout_clear(&worker->sums);
+        rollout_work(rollout_board, &rollout_limits, worker->count, 
+                                                &worker->rng, &worker->sums);
+        pthread_barrier_wait(&rollout_done);
+    }
+}
+
+// Whole games with the rollout player, every move split across the threads
+static int bench_rollout(int argc, char** argv)
+{
+    int threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int games = 10;
+    uint32_t seed = 420;
+    rollout_limits.rollouts = 100;
+    rollout_limits.depth = 0;
+    
+    int opt;
+    while ((opt = getopt(argc, argv, "r:l:t:g:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'r': rollout_limits.rollouts = strtoul(optarg, 0, 0); break;
+            case 'l': rollout_limits.depth = strtoul(optarg, 0, 0); break;
+            case 't': threads = atoi(optarg); break;
+            case 'g': games = atoi(optarg); break;
+            case 's': seed = strtoul(optarg, 0, 0); break;
+            default:
+                fprintf(stderr, "usage: rollout [-r rollouts] [-l depth] "
+                                "[-t threads] [-g games] [-s seed]\n");
+                return 1;
+        }
+    }
+    if (threads < 1)
+        threads = 1;
+    
+    rollout_worker_t* workers;
+    if (posix_memalign((void**) &workers, 64, 
+                                    threads * sizeof(rollout_worker_t)) != 0)
+    {
+        perror("posix_memalign");
+        return 1;
+    }
+    pthread_barrier_init(&rollout_start, 0, threads + 1);
+    pthread_barrier_init(&rollout_done, 0, threads + 1);
+    for (int w = 0; w < threads; w++)
+    {
+        // the games use streams 0..games-1 of seed, so seed + 1 for these
+        rng_seed_stream(&workers[w].rng, seed + 1, w);
+        uint32_t share = rollout_limits.rollouts / threads;
+        uint32_t left = rollout_limits.rollouts % threads;
+        workers[w].count = share + ((uint32_t) w < left);
+        if (pthread_create(&workers[w].thread, 0, rollout_thread, 
+                                                            &workers[w]) != 0)
+        {
+            perror("pthread_create");
+            return 1;
+        }
+    }
+    
+    // the sums get copied out so rollout_finish sees a plain array
+    rollout_sums_t* sums = malloc(threads * sizeof(rollout_sums_t));
+    uint64_t moves = 0;
+    uint64_t steps = 0;
+    uint64_t score = 0;
+    int max_tiles[16] = {0};
+    
+    uint64_t start = tsc_read();
+    for (int g = 0; g < games; g++)
+    {
+        game_t game;
+        rng_seed_stream(&game.rng, seed, g);
+        game_reset(&game);
+        while (!game.lost)
+        {
+            rollout_board = game.board;
+            pthread_barrier_wait(&rollout_start);
+            pthread_barrier_wait(&rollout_done);
+            for (int w = 0; w < threads; w++)
+                sums[w] = workers[w].sums;
+            
+            rollout_result_t result;
+            rollout_finish(game.board, &rollout_limits, sums, threads, &result);
+            if (result.dir < 0)
+                break;
+            game_move(&game, result.dir);
+            moves++;
+            steps += result.steps;
+        }
+        score += game.score;
+        max_tiles[board_max_tile(game.board)]++;
+    }
+    double us = tsc_to_us(tsc_read() - start);
+    
+    rollout_quit = true;
+    pthread_barrier_wait(&rollout_start);
+    for (int w = 0; w < threads; w++)
+        pthread_join(workers[w].thread, 0);
+    pthread_barrier_destroy(&rollout_start);
+    pthread_barrier_destroy(&rollout_done);
+    
+    int won = 0;
+    for (int t = 11; t < 16; t++)
+        won += max_tiles[t];
+    printf("%u rollouts per move, depth %u, %d threads, %d games\n"
+           "%.1f moves/s, %.1f M rollout steps/s\n"
+           "average score %.0f, reached 2048 in %.1f%%\n", 
+           rollout_limits.rollouts, rollout_limits.depth, threads, games, 
+           moves * 1e6 / us, steps / us, (double) score / games, 
+           100.0 * won / games);
+    
+    free(sums);
+    free(workers);
+    return 0;
+}
+
+// Not a benchmark, just what the CPU has and what that picked
+static int bench_cpu(int argc, char** argv)
+{
+    (void) argc;
+    (void) argv;
+    printf("%s:", cpu_vendor());
+    for (int i = 0; i < CPU_FEATURE_COUNT; i++)
+        if (cpu_has(1 << i))
+            printf(" %s", cpu_feature_name(i));
+    printf("\nmoves with %s, n-tuple indices with %s\n", 
+            board_kernel_name(board_kernel()), 
+            cpu_has(CPU_BMI2) ? "pext" : "shifts");
+    
+    // batch_init picks the batch kernel
+    batch_t batch;
+    static uint8_t mem[BATCH_LANES * 16] __attribute__((aligned(BATCH_ALIGN)));
+    batch_init(&batch, mem, BATCH_LANES);
+    printf("batches with %s\n", batch_kernel_name(batch_kernel()));
+    return 0;
+}
+
+struct bench_struct
+{
+    const char* name;
+    int         (*run)(int argc, char** argv);
+    const char* help;
+};
+
+static const struct bench_struct benches[] = {
+    {"search",  bench_search,   "iterative deepening search in whole games"},
+    {"prune",   bench_prune,    "effect of probability cutoffs and sampling"},
+    {"rng",     bench_rng,      "random numbers and spawns per second"},
+    {"moves",   bench_moves,    "all four moves: tables vs SSE2 vs SSSE3"},
+    {"batch",   bench_batch,    "batch engine against one board at a time"},
+    {"rollout", bench_rollout,  "Monte Carlo player spread over all cores"},
+    {"cpu",     bench_cpu,      "CPU features and the implementations picked"},
+};
+
+int main(int argc, char** argv)
+{
+    cpu_init();
+    board_init();
+    eval_init();
+    tsc_init();
+    
+    if (argc > 1)
+        for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++)
+            if (strcmp(argv[1], benches[i].name) == 0)
+                return benches[i].run(argc - 1, argv + 1);
+    
+    fprintf(stderr, "usage: %s <what> [options]\n", argv[0]);
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++)
+        fprintf(stderr, "  %-10s %s\n", benches[i].name, benches[i].help);
+    return 1;
+}
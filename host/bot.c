@@ -0,0 +1,264 @@
+//
+// bot.c - plays the kernel's game over its serial port, hosted (Linux) build only
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+// usage: bot [-g games] [-b batch] [-s seed] [-a file] path
+//
+// path is what the kernel's COM1 is connected to: the socket of qemu's
+// -serial unix:/tmp/arkta.sock,server,nowait or a pty from -serial pty (or a
+// real serial port). It resets the game with a seed and plays random moves,
+// batch moves per command (1 uses REMOTE_CMD_MOVE), and prints how many moves
+// and round trips a second that is. With -a it gets the replays of all games
+// the kernel played since boot afterwards and writes them to file.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "remote.h"
+#include "rng.h"
+
+static int fd;
+static remote_parser_t parser;
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int connect_to(const char* path)
+{
+    struct stat st;
+    if (stat(path, &st) != 0)
+        return -1;
+    if (S_ISSOCK(st.st_mode))
+    {
+        int s = socket(AF_UNIX, SOCK_STREAM, 0);
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+        if (s < 0 || connect(s, (struct sockaddr*) &addr, sizeof(addr)) != 0)
+            return -1;
+        return s;
+    }
+    int f = open(path, O_RDWR | O_NOCTTY);
+    struct termios tio;
+    if (f >= 0 && tcgetattr(f, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        cfsetspeed(&tio, B115200);
+        tcsetattr(f, TCSANOW, &tio);
+    }
+    return f;
+}
+
+static void send_frame(uint8_t command, const void* payload, size_t length)
+{
+    uint8_t frame[REMOTE_MAX_FRAME];
+    size_t size = remote_encode(command, payload, length, frame);
+    for (size_t done = 0; done < size; )
+    {
+        ssize_t n = write(fd, frame + done, size - done);
+        if (n < 0 && errno != EINTR)
+        {
+            perror("write");
+            exit(1);
+        }
+        done += n > 0 ? n : 0;
+    }
+}
+
+// Waits for the reply to the last command, anything else in between (like
+// what the kernel printed while booting) is skipped
+static const remote_frame_t* receive(uint8_t command)
+{
+    uint8_t buffer[256];
+    for (;;)
+    {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n <= 0)
+        {
+            if (n < 0 && errno == EINTR)
+                continue;
+            fprintf(stderr, "connection closed\n");
+            exit(1);
+        }
+        for (ssize_t i = 0; i < n; i++)
+        {
+            int status = remote_feed(&parser, buffer[i]);
+            if (status != REMOTE_FRAME)
+                continue;
+            const remote_frame_t* frame = &parser.frame;
+            if (frame->command == REMOTE_REPLY_ERROR)
+            {
+                fprintf(stderr, "kernel says: %s\n", 
+                                remote_strerror((int8_t) frame->payload[0]));
+                exit(1);
+            }
+            // one command at a time, so nothing can come after it
+            if (frame->command == command)
+                return frame;
+        }
+    }
+}
+
+static void receive_state(remote_state_t* state)
+{
+    memcpy(state, receive(REMOTE_REPLY_STATE)->payload, sizeof(*state));
+}
+
+static void save_replays(const char* path)
+{
+    FILE* f = fopen(path, "wb");
+    if (f == 0)
+    {
+        perror(path);
+        exit(1);
+    }
+    uint32_t offset = 0;
+    remote_replay_t header;
+    do
+    {
+        send_frame(REMOTE_CMD_REPLAY, &offset, sizeof(offset));
+        const remote_frame_t* frame = receive(REMOTE_REPLY_REPLAY);
+        memcpy(&header, frame->payload, sizeof(header));
+        size_t length = frame->length - sizeof(header);
+        fwrite(frame->payload + sizeof(header), 1, length, f);
+        offset += length;
+        if (length == 0)
+            break;
+    }
+    while (offset < header.size);
+    fclose(f);
+    printf("%u bytes of replays written to %s\n", offset, path);
+    if (header.flags & REMOTE_FULL)
+        printf("the kernel ran out of room, later games weren't recorded\n");
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, 
+        "usage: %s [options] path\n"
+        "  -g games                default is 10\n"
+        "  -b batch                moves per command, up to %d, default 256\n"
+        "  -s seed                 seed of the first game, then +1 each\n"
+        "  -a file                 write the replays of all games there\n",
+        name, REMOTE_MAX_BATCH);
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    int games = 10;
+    int batch = 256;
+    uint64_t seed = 1;
+    const char* archive = 0;
+    
+    int opt;
+    while ((opt = getopt(argc, argv, "g:b:s:a:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'g': games = atoi(optarg); break;
+            case 'b': batch = atoi(optarg); break;
+            case 's': seed = strtoull(optarg, 0, 10); break;
+            case 'a': archive = optarg; break;
+            default: usage(argv[0]);
+        }
+    }
+    if (games < 1 || batch < 1 || batch > REMOTE_MAX_BATCH || optind != argc - 1)
+        usage(argv[0]);
+    
+    fd = connect_to(argv[optind]);
+    if (fd < 0)
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+    remote_parser_init(&parser);
+    
+    rng_t rng;
+    rng_seed(&rng, seed);
+    uint8_t* dirs = malloc(batch);
+    uint64_t moves = 0;
+    uint64_t trips = 0;
+    uint64_t total_score = 0;
+    double start = now();
+    for (int g = 0; g < games; g++)
+    {
+        uint64_t game_seed = seed + g;
+        remote_state_t state;
+        send_frame(REMOTE_CMD_RESET, &game_seed, sizeof(game_seed));
+        receive_state(&state);
+        trips++;
+        
+        while (!(state.flags & REMOTE_LOST))
+        {
+            for (int i = 0; i < batch; i++)
+                dirs[i] = rng_below(&rng, DIR_COUNT);
+            if (batch == 1)
+                send_frame(REMOTE_CMD_MOVE, dirs, 1);
+            else
+            {
+                uint8_t payload[REMOTE_MAX_PAYLOAD];
+                send_frame(REMOTE_CMD_BATCH, payload, 
+                                    remote_pack_batch(dirs, batch, payload));
+            }
+            receive_state(&state);
+            trips++;
+            moves += state.applied;
+        }
+        total_score += state.score;
+        printf("game %d: score %llu, max tile %d\n", g + 1, 
+                (unsigned long long) state.score, 
+                1 << board_max_tile(state.board));
+    }
+    double elapsed = now() - start;
+    
+    printf("%d games, %.0f moves/s, %.0f round trips/s, average score %.0f\n",
+           games, moves / elapsed, trips / elapsed, 
+           (double) total_score / games);
+    if (archive != 0)
+        save_replays(archive);
+    free(dirs);
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,504 @@
+//
+// sim.c - headless batch games, hosted (Linux) build only
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+
+// Plays lots of games without a keyboard with one of a few policies on all
+// cores and prints how they went. Game g uses rng stream g of the base seed,
+// so the same command gives the same games no matter how many threads play
+// them. Not with -b, how deep the search gets depends on the machine.
+
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "cpu.h"
+#include "eval.h"
+#include "game.h"
+#include "ntuple.h"
+#include "replay.h"
+#include "rng.h"
+#include "rollout.h"
+#include "search.h"
+#include "tsc.h"
+
+#define TABLE_SIZE  (1 << 20)
+
+enum policy_enum
+{
+    POLICY_RANDOM,
+    POLICY_GREEDY,
+    POLICY_SEARCH,
+    POLICY_ROLLOUT,
+};
+
+static const char* policy_names[] = {"random", "greedy", "search", "rollout"};
+
+struct result_struct
+{
+    uint64_t    score;
+    uint32_t    moves;
+    uint32_t    max_tile;
+};
+typedef struct result_struct result_t;
+
+static int              policy = POLICY_SEARCH;
+static search_limits_t  limits;
+static rollout_limits_t rollout_limits;
+static long             total_games = 1000;
+static int              thread_count;
+static uint32_t         seed = 420;
+static bool             verbose;
+
+// every game's replay goes in there, in the order they're done
+static FILE*            archive;
+static pthread_mutex_t  archive_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static result_t*        results;
+static long             games_started;
+static long             games_done;
+
+static ntuple_t weights;
+
+static void load_weights(const char* path)
+{
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        perror(path);
+        exit(1);
+    }
+    void* buf = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (buf == MAP_FAILED)
+    {
+        perror(path);
+        exit(1);
+    }
+    int err = ntuple_map(&weights, buf, st.st_size);
+    if (err != NTUPLE_OK)
+    {
+        fprintf(stderr, "%s: %s\n", path, ntuple_strerror(err));
+        exit(1);
+    }
+    eval_set_network(&weights);
+}
+
+// from its own stream, the game's only makes spawns or replays can't follow
+static int random_move(game_t* game, const board_t after[DIR_COUNT], 
+                                                                rng_t* rng)
+{
+    int legal[DIR_COUNT];
+    int count = 0;
+    for (int dir = 0; dir < DIR_COUNT; dir++)
+        if (after[dir] != game->board)
+            legal[count++] = dir;
+    if (count == 0)
+        return -1;
+    return legal[rng_below(rng, count)];
+}
+
+// the biggest immediate score, the first of those if there's a tie
+static int greedy_move(game_t* game, const board_t after[DIR_COUNT], 
+                                            const uint32_t score[DIR_COUNT])
+{
+    int best = -1;
+    for (int dir = 0; dir < DIR_COUNT; dir++)
+    {
+        if (after[dir] == game->board)
+            continue;
+        if (best < 0 || score[dir] > score[best])
+            best = dir;
+    }
+    return best;
+}
+
+// One game's replay, it's kept until the game is over so the games don't
+// get mixed up in the archive
+struct recording_struct
+{
+    uint8_t*    data;
+    size_t      size;
+    size_t      capacity;
+};
+typedef struct recording_struct recording_t;
+
+static void record_write(void* ctx, const void* data, size_t size)
+{
+    recording_t* rec = ctx;
+    if (rec->size + size > rec->capacity)
+    {
+        rec->capacity = rec->capacity * 2 + size;
+        rec->data = realloc(rec->data, rec->capacity);
+        if (rec->data == 0)
+        {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    memcpy(rec->data + rec->size, data, size);
+    rec->size += size;
+}
+
+static void play(long g, search_t* search, recording_t* rec, result_t* result)
+{
+    game_t game;
+    rng_seed_stream(&game.rng, seed, g);
+    replay_writer_t writer;
+    if (archive != 0)
+    {
+        rec->size = 0;
+        replay_begin(&writer, record_write, rec, &game.rng);
+    }
+    game_reset(&game);
+    // the random moves and the rollouts can't share the game's stream or
+    // they'd move the spawns
+    rng_t policy_rng;
+    rng_seed_stream(&policy_rng, seed + 1, g);
+    // an empty table and a sampling stream of the game's own, or how the
+    // game goes would depend on which ones the thread played before it
+    if (policy == POLICY_SEARCH)
+    {
+        search_clear(search);
+        rng_seed_stream(&search->rng, seed + 2, g);
+    }
+    
+    uint32_t moves = 0;
+    while (!game.lost)
+    {
+        int dir;
+        board_t after[DIR_COUNT];
+        uint32_t score[DIR_COUNT];
+        if (policy == POLICY_SEARCH)
+        {
+            search_result_t sr;
+            search_run(search, game.board, &limits, &sr);
+            dir = sr.dir;
+            memcpy(after, sr.after, sizeof(after));
+            memcpy(score, sr.reward, sizeof(score));
+        }
+        else
+        {
+            board_move_all(game.board, after, score);
+            if (policy == POLICY_RANDOM)
+                dir = random_move(&game, after, &policy_rng);
+            else if (policy == POLICY_GREEDY)
+                dir = greedy_move(&game, after, score);
+            else
+            {
+                rollout_result_t rr;
+                rollout_run(game.board, &rollout_limits, &policy_rng, &rr);
+                dir = rr.dir;
+            }
+        }
+        if (dir < 0)
+            break;
+        board_t before = game.board;
+        game_play(&game, after[dir], score[dir]);
+        if (archive != 0)
+            replay_record(&writer, before, dir, &game);
+        moves++;
+    }
+    
+    if (archive != 0)
+    {
+        replay_finish(&writer, &game);
+        pthread_mutex_lock(&archive_lock);
+        if (fwrite(rec->data, 1, rec->size, archive) != rec->size)
+        {
+            perror("archive");
+            exit(1);
+        }
+        pthread_mutex_unlock(&archive_lock);
+    }
+    
+    result->score = game.score;
+    result->moves = moves;
+    result->max_tile = board_max_tile(game.board);
+}
+
+static void* work(void* arg)
+{
+    (void) arg;
+    search_t search;
+    search_entry_t* table = 0;
+    if (policy == POLICY_SEARCH)
+    {
+        table = malloc(TABLE_SIZE * sizeof(search_entry_t));
+        if (table == 0)
+        {
+            perror("malloc");
+            exit(1);
+        }
+        // play() clears it for every game
+        search_init(&search, table, TABLE_SIZE);
+    }
+    recording_t rec = {0, 0, 0};
+    
+    long g;
+    while ((g = __atomic_fetch_add(&games_started, 1, __ATOMIC_RELAXED)) < 
+                                                                    total_games)
+    {
+        play(g, &search, &rec, &results[g]);
+        __atomic_add_fetch(&games_done, 1, __ATOMIC_RELAXED);
+        if (verbose)
+            fprintf(stderr, "game %ld: score %llu, max tile %d, %u moves\n", 
+                    g, (unsigned long long) results[g].score, 
+                    1 << results[g].max_tile, results[g].moves);
+    }
+    free(table);
+    free(rec.data);
+    return 0;
+}
+
+static int compare_u64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*) a;
+    uint64_t y = *(const uint64_t*) b;
+    return x < y ? -1 : x > y;
+}
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(FILE* out, double wall)
+{
+    uint64_t* scores = malloc(total_games * sizeof(uint64_t));
+    uint64_t* moves = malloc(total_games * sizeof(uint64_t));
+    if (scores == 0 || moves == 0)
+    {
+        perror("malloc");
+        exit(1);
+    }
+    
+    long tiles[16];
+    memset(tiles, 0, sizeof(tiles));
+    double score_sum = 0;
+    double score_sq = 0;
+    uint64_t move_sum = 0;
+    for (long g = 0; g < total_games; g++)
+    {
+        scores[g] = results[g].score;
+        moves[g] = results[g].moves;
+        score_sum += scores[g];
+        score_sq += (double) scores[g] * scores[g];
+        move_sum += moves[g];
+        tiles[results[g].max_tile]++;
+    }
+    qsort(scores, total_games, sizeof(uint64_t), compare_u64);
+    qsort(moves, total_games, sizeof(uint64_t), compare_u64);
+    
+    double mean = score_sum / total_games;
+    double var = score_sq / total_games - mean * mean;
+    
+    fprintf(out, "policy %s", policy_names[policy]);
+    if (policy == POLICY_SEARCH)
+        fprintf(out, ", max depth %d, budget %u us, min prob %g, "
+                "sample %d cells, %s", limits.max_depth, limits.budget_us, 
+                limits.min_prob, limits.sample_cells, 
+                eval_has_network() ? "n-tuple" : "heuristic");
+    else if (policy == POLICY_ROLLOUT)
+        fprintf(out, ", %u rollouts per move, depth %u", 
+                rollout_limits.rollouts, rollout_limits.depth);
+    fprintf(out, "\n%ld games, seed %u, %d threads\n\n", total_games, seed, 
+                                                                thread_count);
+    
+    static const int percentiles[] = {1, 10, 25, 50, 75, 90, 99};
+    fprintf(out, "score: mean %.1f, stddev %.1f, min %llu, max %llu\n", 
+            mean, var > 0 ? sqrt(var) : 0.0, 
+            (unsigned long long) scores[0], 
+            (unsigned long long) scores[total_games - 1]);
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++)
+        fprintf(out, "  p%-2d %llu\n", percentiles[i], 
+            (unsigned long long) scores[(total_games - 1) * percentiles[i] / 100]);
+    
+    fprintf(out, "\nmax tile     games   reached\n");
+    long reached = total_games;
+    for (int t = 0; t < 16; t++)
+    {
+        if (tiles[t] != 0)
+            fprintf(out, "%8d  %8ld  %7.2f%%\n", 1 << t, tiles[t], 
+                                                100.0 * reached / total_games);
+        reached -= tiles[t];
+    }
+    
+    fprintf(out, "\nmoves per game: mean %.1f, min %llu, median %llu, "
+            "max %llu\n", (double) move_sum / total_games, 
+            (unsigned long long) moves[0], 
+            (unsigned long long) moves[(total_games - 1) / 2], 
+            (unsigned long long) moves[total_games - 1]);
+    fprintf(out, "wall time %.2f s, %.1f games/s, %.0f moves/s\n", wall, 
+            total_games / wall, move_sum / wall);
+    
+    free(scores);
+    free(moves);
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, 
+        "usage: %s [options]\n"
+        "  -P random|greedy|search|rollout\n"
+        "                          policy (default search)\n"
+        "  -d depth                search depth (default 2)\n"
+        "  -b budget_us            time per move instead of a fixed depth\n"
+        "  -p min_prob             probability cutoff for the search\n"
+        "  -c cells                search only that many random empty cells\n"
+        "  -w file                 n-tuple weights for the search\n"
+        "  -r rollouts             rollouts per first move (default 100)\n"
+        "  -l length               moves per rollout, 0 plays it out\n"
+        "  -g games                games to play (default 1000)\n"
+        "  -t threads              default is one per core\n"
+        "  -s seed                 base seed, every game gets its own stream\n"
+        "  -o file                 write the statistics there\n"
+        "  -a file                 write the replays of all games there\n"
+        "  -v                      print every game to stderr\n",
+        name);
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    const char* output = 0;
+    const char* archive_path = 0;
+    thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+    limits.budget_us = 0;
+    limits.max_depth = 2;
+    limits.min_prob = 0;
+    limits.sample_cells = 0;
+    limits.abort = 0;
+    rollout_limits.rollouts = 100;
+    rollout_limits.depth = 0;
+    
+    cpu_init();
+    board_init();
+    eval_init();
+    tsc_init();
+    
+    int opt;
+    while ((opt = getopt(argc, argv, "P:d:b:p:c:w:r:l:g:t:s:o:a:vh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'P':
+                policy = -1;
+                for (int i = 0; i <= POLICY_ROLLOUT; i++)
+                    if (strcmp(optarg, policy_names[i]) == 0)
+                        policy = i;
+                if (policy < 0)
+                    usage(argv[0]);
+                break;
+            case 'd': limits.max_depth = atoi(optarg); break;
+            case 'b': limits.budget_us = strtoul(optarg, 0, 0); break;
+            case 'p': limits.min_prob = atof(optarg); break;
+            case 'c': limits.sample_cells = atoi(optarg); break;
+            case 'w': load_weights(optarg); break;
+            case 'r': rollout_limits.rollouts = strtoul(optarg, 0, 0); break;
+            case 'l': rollout_limits.depth = strtoul(optarg, 0, 0); break;
+            case 'g': total_games = atol(optarg); break;
+            case 't': thread_count = atoi(optarg); break;
+            case 's': seed = strtoul(optarg, 0, 0); break;
+            case 'o': output = optarg; break;
+            case 'a': archive_path = optarg; break;
+            case 'v': verbose = true; break;
+            default: usage(argv[0]);
+        }
+    }
+    if (thread_count < 1 || total_games < 1 || limits.max_depth < 1)
+        usage(argv[0]);
+    
+    results = calloc(total_games, sizeof(result_t));
+    pthread_t* threads = malloc(thread_count * sizeof(pthread_t));
+    if (results == 0 || threads == 0)
+    {
+        perror("malloc");
+        return 1;
+    }
+    if (archive_path != 0 && (archive = fopen(archive_path, "wb")) == 0)
+    {
+        perror(archive_path);
+        return 1;
+    }
+    
+    double start = now();
+    for (int i = 0; i < thread_count; i++)
+        if (pthread_create(&threads[i], 0, work, 0) != 0)
+        {
+            perror("pthread_create");
+            return 1;
+        }
+    
+    // progress for the long runs, about once a second
+    for (int tick = 1; 
+            __atomic_load_n(&games_done, __ATOMIC_RELAXED) < total_games; 
+                                                                        tick++)
+    {
+        usleep(10000);
+        if (!verbose && tick % 100 == 0)
+            fprintf(stderr, "\r%ld/%ld games", 
+                    __atomic_load_n(&games_done, __ATOMIC_RELAXED), 
+                    total_games);
+    }
+    if (!verbose)
+        fprintf(stderr, "\n");
+    for (int i = 0; i < thread_count; i++)
+        pthread_join(threads[i], 0);
+    double wall = now() - start;
+    if (archive != 0 && fclose(archive) != 0)
+    {
+        perror(archive_path);
+        return 1;
+    }
+    
+    FILE* out = stdout;
+    if (output != 0 && (out = fopen(output, "w")) == 0)
+    {
+        perror(output);
+        return 1;
+    }
+    report(out, wall);
+    if (out != stdout && fclose(out) != 0)
+    {
+        perror(output);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,468 @@
+//
+// train.c - TD learning of n-tuple weights, hosted (Linux) build only
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+// Plays games against itself on all cores and learns afterstate values with
+// TD(0) or TD(lambda). All the threads update the same float tables without
+// any locking (Hogwild!), a lost update here and there doesn't matter.
+// Checkpoints are written in the weight format the kernel loads, see ntuple.h.
+
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "cpu.h"
+#include "ntuple.h"
+#include "rng.h"
+
+struct preset_struct
+{
+    const char*     name;
+    int             count;
+    ntuple_tuple_t  tuples[4];
+};
+typedef struct preset_struct preset_t;
+
+// cell numbers are x * 4 + y, see board.h
+static const preset_t presets[] = {
+    {"small",  4, {{4, {0, 1, 2, 3}},       {4, {4, 5, 6, 7}},
+                   {4, {0, 1, 4, 5}},       {4, {5, 6, 9, 10}}}},
+    {"medium", 4, {{5, {0, 1, 2, 3, 4}},    {5, {4, 5, 6, 7, 8}},
+                   {5, {0, 1, 2, 4, 5}},    {5, {4, 5, 6, 8, 9}}}},
+    {"large",  4, {{6, {0, 1, 2, 3, 4, 5}}, {6, {4, 5, 6, 7, 8, 9}},
+                   {6, {0, 1, 2, 4, 5, 6}}, {6, {4, 5, 6, 8, 9, 10}}}},
+};
+
+static int              tuple_count;
+static ntuple_tuple_t   tuples[NTUPLE_MAX_TUPLES];
+static float*           tables[NTUPLE_MAX_TUPLES];
+
+static float    alpha = 0.1f;   // per board, split over all the lookups
+static float    lambda = 0.0f;
+static long     total_games = 100000;
+static long     checkpoint_every = 10000;
+static int      thread_count;
+static uint32_t seed = 420;
+static const char* output = "weights.ntw";
+
+// shared progress, only touched with atomics
+static long     games_started;
+static long     games_done;
+static long     moves_done;
+static uint64_t score_sum;
+static long     wins;           // games that reached 2048
+
+struct step_struct
+{
+    board_t     after;
+    uint32_t    reward;
+};
+typedef struct step_struct step_t;
+
+struct worker_struct
+{
+    pthread_t   thread;
+    rng_t       rng;
+    step_t*     steps;          // the episode, for TD(lambda)
+    size_t      steps_size;
+};
+typedef struct worker_struct worker_t;
+
+static float value(board_t board)
+{
+    board_t sym[8];
+    ntuple_symmetries(board, sym);
+    float sum = 0;
+    for (int i = 0; i < tuple_count; i++)
+        for (int s = 0; s < 8; s++)
+            sum += tables[i][ntuple_index(&tuples[i], sym[s])];
+    return sum;
+}
+
+static void learn(board_t board, float error)
+{
+    board_t sym[8];
+    ntuple_symmetries(board, sym);
+    float delta = alpha * error / (tuple_count * 8);
+    for (int i = 0; i < tuple_count; i++)
+        for (int s = 0; s < 8; s++)
+            tables[i][ntuple_index(&tuples[i], sym[s])] += delta;
+}
+
+// Picks the move with the best reward + afterstate value, returns false if
+// there's no legal move
+static bool choose(board_t board, board_t* after, uint32_t* reward)
+{
+    board_t a[DIR_COUNT];
+    uint32_t r[DIR_COUNT];
+    board_move_all(board, a, r);
+    
+    bool found = false;
+    float best = 0;
+    for (int dir = 0; dir < DIR_COUNT; dir++)
+    {
+        if (a[dir] == board)
+            continue;
+        float v = r[dir] + value(a[dir]);
+        if (!found || v > best)
+        {
+            found = true;
+            best = v;
+            *after = a[dir];
+            *reward = r[dir];
+        }
+    }
+    return found;
+}
+
+static void play(worker_t* w)
+{
+    board_t board = board_spawn(board_spawn(0, &w->rng), &w->rng);
+    uint64_t score = 0;
+    size_t moves = 0;
+    board_t prev = 0;
+    board_t after = 0;
+    uint32_t reward = 0;
+    
+    while (choose(board, &after, &reward))
+    {
+        if (lambda == 0)
+        {
+            if (moves > 0)
+                learn(prev, reward + value(after) - value(prev));
+        }
+        else
+        {
+            if (moves == w->steps_size)
+            {
+                w->steps_size = w->steps_size ? w->steps_size * 2 : 4096;
+                w->steps = realloc(w->steps, w->steps_size * sizeof(step_t));
+                if (w->steps == 0)
+                {
+                    perror("realloc");
+                    exit(1);
+                }
+            }
+            w->steps[moves].after = after;
+            w->steps[moves].reward = reward;
+        }
+        prev = after;
+        moves++;
+        score += reward;
+        board = board_spawn(after, &w->rng);
+    }
+    
+    if (moves > 0)
+    {
+        if (lambda == 0)
+        {
+            learn(prev, -value(prev));  // nothing comes after the last one
+        }
+        else
+        {
+            // lambda returns, from the end backwards
+            float ret = 0;
+            for (size_t t = moves; t-- > 0;)
+            {
+                if (t + 1 < moves)
+                    ret = w->steps[t + 1].reward + (1 - lambda) * 
+                                value(w->steps[t + 1].after) + lambda * ret;
+                learn(w->steps[t].after, ret - value(w->steps[t].after));
+            }
+        }
+    }
+    
+    __atomic_add_fetch(&moves_done, (long) moves, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&score_sum, score, __ATOMIC_RELAXED);
+    if (board_max_tile(board) >= 11)
+        __atomic_add_fetch(&wins, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&games_done, 1, __ATOMIC_RELEASE);
+}
+
+static void* work(void* arg)
+{
+    worker_t* w = arg;
+    while (__atomic_fetch_add(&games_started, 1, __ATOMIC_RELAXED) < 
+                                                                    total_games)
+        play(w);
+    return 0;
+}
+
+static int save(const char* path)
+{
+    float max = 0;
+    for (int i = 0; i < tuple_count; i++)
+        for (size_t j = 0; j < ntuple_table_size(tuples[i].length); j++)
+            if (fabsf(tables[i][j]) > max)
+                max = fabsf(tables[i][j]);
+    
+    int frac_bits = 14;
+    while (frac_bits > 0 && max * (1 << frac_bits) > 32767)
+        frac_bits--;
+    
+    ntuple_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = NTUPLE_MAGIC;
+    header.version = NTUPLE_VERSION;
+    header.count = tuple_count;
+    header.frac_bits = frac_bits;
+    header.weights_offset = (sizeof(header) + 
+            tuple_count * sizeof(ntuple_tuple_t) + NTUPLE_ALIGN - 1) / 
+                                                    NTUPLE_ALIGN * NTUPLE_ALIGN;
+    
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE* file = fopen(tmp, "wb");
+    if (file == 0)
+    {
+        perror(tmp);
+        return -1;
+    }
+    
+    static const char zeros[NTUPLE_ALIGN];
+    size_t head = sizeof(header) + tuple_count * sizeof(ntuple_tuple_t);
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(tuples, sizeof(ntuple_tuple_t), tuple_count, file);
+    fwrite(zeros, 1, header.weights_offset - head, file);
+    
+    for (int i = 0; i < tuple_count; i++)
+    {
+        int16_t buf[4096];
+        size_t size = ntuple_table_size(tuples[i].length);
+        for (size_t j = 0; j < size; j += 4096)
+        {
+            size_t n = size - j < 4096 ? size - j : 4096;
+            for (size_t k = 0; k < n; k++)
+            {
+                long q = lrintf(tables[i][j + k] * (1 << frac_bits));
+                buf[k] = q > 32767 ? 32767 : q < -32768 ? -32768 : q;
+            }
+            fwrite(buf, sizeof(int16_t), n, file);
+        }
+    }
+    
+    if (ferror(file) || fclose(file) != 0 || rename(tmp, path) != 0)
+    {
+        perror(path);
+        return -1;
+    }
+    return 0;
+}
+
+static void load(const char* path)
+{
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        perror(path);
+        exit(1);
+    }
+    void* buf = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (buf == MAP_FAILED)
+    {
+        perror(path);
+        exit(1);
+    }
+    
+    ntuple_t net;
+    int err = ntuple_map(&net, buf, st.st_size);
+    if (err != NTUPLE_OK)
+    {
+        fprintf(stderr, "%s: %s\n", path, ntuple_strerror(err));
+        exit(1);
+    }
+    
+    tuple_count = net.count;
+    float scale = 1.0f / (1 << net.frac_bits);
+    for (int i = 0; i < net.count; i++)
+    {
+        tuples[i] = net.tuples[i];
+        size_t size = ntuple_table_size(tuples[i].length);
+        tables[i] = malloc(size * sizeof(float));
+        if (tables[i] == 0)
+        {
+            perror("malloc");
+            exit(1);
+        }
+        for (size_t j = 0; j < size; j++)
+            tables[i][j] = net.tables[i][j] * scale;
+    }
+    
+    munmap(buf, st.st_size);
+    close(fd);
+}
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, 
+        "usage: %s [options]\n"
+        "  -n small|medium|large   tuple set to train (default medium)\n"
+        "  -i file                 continue training the weights in file\n"
+        "  -o file                 where to checkpoint (default weights.ntw)\n"
+        "  -g games                games to play in total (default 100000)\n"
+        "  -c games                checkpoint every that many games\n"
+        "  -a alpha                learning rate (default 0.1)\n"
+        "  -l lambda               0 for TD(0) (default), else TD(lambda)\n"
+        "  -t threads              default is one per core\n"
+        "  -s seed                 base seed, every thread gets its own stream\n",
+        name);
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    const char* preset = "medium";
+    const char* input = 0;
+    thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+    
+    int opt;
+    while ((opt = getopt(argc, argv, "n:i:o:g:c:a:l:t:s:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': preset = optarg; break;
+            case 'i': input = optarg; break;
+            case 'o': output = optarg; break;
+            case 'g': total_games = atol(optarg); break;
+            case 'c': checkpoint_every = atol(optarg); break;
+            case 'a': alpha = atof(optarg); break;
+            case 'l': lambda = atof(optarg); break;
+            case 't': thread_count = atoi(optarg); break;
+            case 's': seed = strtoul(optarg, 0, 0); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (thread_count < 1 || checkpoint_every < 1 || lambda < 0 || lambda > 1)
+        usage(argv[0]);
+    
+    cpu_init();
+    board_init();
+    
+    if (input != 0)
+    {
+        load(input);
+    }
+    else
+    {
+        const preset_t* p = 0;
+        for (size_t i = 0; i < sizeof(presets) / sizeof(presets[0]); i++)
+            if (strcmp(presets[i].name, preset) == 0)
+                p = &presets[i];
+        if (p == 0)
+            usage(argv[0]);
+        tuple_count = p->count;
+        for (int i = 0; i < p->count; i++)
+        {
+            tuples[i] = p->tuples[i];
+            tables[i] = calloc(ntuple_table_size(tuples[i].length), 
+                                                                sizeof(float));
+            if (tables[i] == 0)
+            {
+                perror("calloc");
+                return 1;
+            }
+        }
+    }
+    
+    size_t weights = 0;
+    for (int i = 0; i < tuple_count; i++)
+        weights += ntuple_table_size(tuples[i].length);
+    printf("%d tuples, %zu weights, %d threads, TD(%g), alpha %g\n", 
+                            tuple_count, weights, thread_count, lambda, alpha);
+    
+    worker_t* workers = calloc(thread_count, sizeof(worker_t));
+    double start = now();
+    for (int i = 0; i < thread_count; i++)
+    {
+        rng_seed_stream(&workers[i].rng, seed, i);
+        pthread_create(&workers[i].thread, 0, work, &workers[i]);
+    }
+    
+    long next = checkpoint_every < total_games ? checkpoint_every : total_games;
+    long last_games = 0;
+    uint64_t last_score = 0;
+    long last_wins = 0;
+    double last_time = start;
+    for (;;)
+    {
+        long done = __atomic_load_n(&games_done, __ATOMIC_ACQUIRE);
+        if (done < next)
+        {
+            usleep(10000);
+            continue;
+        }
+        
+        double t = now();
+        uint64_t score = __atomic_load_n(&score_sum, __ATOMIC_RELAXED);
+        long won = __atomic_load_n(&wins, __ATOMIC_RELAXED);
+        long games = done - last_games;
+        printf("%ld games: avg score %.0f, 2048 rate %.1f%%, "
+               "%.0f games/hour/core\n", done, 
+               (double) (score - last_score) / games, 
+               100.0 * (won - last_wins) / games, 
+               games / ((t - last_time) / 3600) / thread_count);
+        fflush(stdout);
+        save(output);
+        
+        last_games = done;
+        last_score = score;
+        last_wins = won;
+        last_time = t;
+        if (done >= total_games)
+            break;
+        next = done + checkpoint_every < total_games ? 
+                                    done + checkpoint_every : total_games;
+    }
+    
+    for (int i = 0; i < thread_count; i++)
+        pthread_join(workers[i].thread, 0);
+    
+    double elapsed = now() - start;
+    printf("%ld games, %ld moves in %.1f s: %.0f games/hour/core, "
+           "%.0f moves/s\n", games_done, moves_done, elapsed, 
+           games_done / (elapsed / 3600) / thread_count, 
+           moves_done / elapsed);
+    return 0;
+}
@@ -0,0 +1,256 @@
+//
+// verify.c - checks recorded games, hosted (Linux) build only
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+
+// usage: verify [-t threads] [-v] files...
+//
+// Every file can have any number of replays one after another (host/sim -a
+// writes them like that). They are all played again on all cores, with the
+// spawns, checkpoints and final scores checked, and the ones that don't
+// check out are printed with the first move that went wrong.
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "cpu.h"
+#include "game.h"
+#include "replay.h"
+
+// replays are handed out this many at a time, they're small
+#define CHUNK   64
+
+struct file_struct
+{
+    const char*     path;
+    const uint8_t*  data;
+    size_t          size;
+};
+typedef struct file_struct file_t;
+
+struct entry_struct
+{
+    int             file;
+    size_t          offset;
+    size_t          size;       // to the end of the file if it's unreadable
+    replay_check_t  check;
+};
+typedef struct entry_struct entry_t;
+
+static file_t*      files;
+static entry_t*     entries;
+static size_t       entry_count;
+static size_t       entry_capacity;
+static size_t       next_entry;
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void add_entry(int file, size_t offset, size_t size)
+{
+    if (entry_count == entry_capacity)
+    {
+        entry_capacity = entry_capacity * 2 + 1024;
+        entries = realloc(entries, entry_capacity * sizeof(entry_t));
+        if (entries == 0)
+        {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    entries[entry_count].file = file;
+    entries[entry_count].offset = offset;
+    entries[entry_count].size = size;
+    entry_count++;
+}
+
+// Finds where the replays in a file start and end, without playing them. If
+// one can't be read to the end the rest of the file is one entry, verifying
+// it says what's wrong.
+static void index_file(int file)
+{
+    const uint8_t* data = files[file].data;
+    size_t size = files[file].size;
+    size_t offset = 0;
+    while (offset < size)
+    {
+        size_t length = replay_length(data + offset, size - offset);
+        if (length == 0)
+        {
+            add_entry(file, offset, size - offset);
+            return;
+        }
+        add_entry(file, offset, length);
+        offset += length;
+    }
+}
+
+static void* work(void* arg)
+{
+    (void) arg;
+    size_t first;
+    while ((first = __atomic_fetch_add(&next_entry, CHUNK, __ATOMIC_RELAXED)) < 
+                                                                    entry_count)
+    {
+        size_t last = first + CHUNK < entry_count ? first + CHUNK : entry_count;
+        for (size_t i = first; i < last; i++)
+        {
+            entry_t* entry = &entries[i];
+            replay_verify(files[entry->file].data + entry->offset, entry->size, 
+                                                                &entry->check);
+        }
+    }
+    return 0;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, 
+        "usage: %s [options] files...\n"
+        "  -t threads              default is one per core\n"
+        "  -v                      print every replay, not just the bad ones\n",
+        name);
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    int thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+    bool verbose = false;
+    
+    int opt;
+    while ((opt = getopt(argc, argv, "t:vh")) != -1)
+    {
+        switch (opt)
+        {
+            case 't': thread_count = atoi(optarg); break;
+            case 'v': verbose = true; break;
+            default: usage(argv[0]);
+        }
+    }
+    if (thread_count < 1 || optind == argc)
+        usage(argv[0]);
+    
+    cpu_init();
+    board_init();
+    
+    int file_count = argc - optind;
+    files = calloc(file_count, sizeof(file_t));
+    pthread_t* threads = malloc(thread_count * sizeof(pthread_t));
+    if (files == 0 || threads == 0)
+    {
+        perror("malloc");
+        return 1;
+    }
+    
+    double start = now();
+    for (int f = 0; f < file_count; f++)
+    {
+        const char* path = argv[optind + f];
+        int fd = open(path, O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0)
+        {
+            perror(path);
+            return 1;
+        }
+        files[f].path = path;
+        files[f].size = st.st_size;
+        if (st.st_size == 0)
+            continue;
+        void* data = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            perror(path);
+            return 1;
+        }
+        close(fd);
+        // it's read front to back, twice
+        madvise(data, st.st_size, MADV_SEQUENTIAL);
+        files[f].data = data;
+        index_file(f);
+    }
+    double indexed = now();
+    
+    for (int i = 0; i < thread_count; i++)
+        if (pthread_create(&threads[i], 0, work, 0) != 0)
+        {
+            perror("pthread_create");
+            return 1;
+        }
+    for (int i = 0; i < thread_count; i++)
+        pthread_join(threads[i], 0);
+    double done = now();
+    
+    size_t bad = 0;
+    size_t other_engine = 0;
+    uint64_t moves = 0;
+    for (size_t i = 0; i < entry_count; i++)
+    {
+        const entry_t* entry = &entries[i];
+        const replay_check_t* check = &entry->check;
+        moves += check->moves;
+        if (check->err == REPLAY_OK && check->engine != GAME_ENGINE_VERSION)
+            other_engine++;
+        if (check->err != REPLAY_OK)
+        {
+            bad++;
+            printf("%s at %zu: move %u: %s\n", files[entry->file].path, 
+                    entry->offset, check->moves + 1, 
+                    replay_strerror(check->err));
+        }
+        else if (verbose)
+            printf("%s at %zu: %u moves, score %llu\n", 
+                    files[entry->file].path, entry->offset, check->moves, 
+                    (unsigned long long) check->score);
+    }
+    
+    double wall = done - start;
+    printf("%zu replays, %zu bad, %llu moves\n"
+           "%.2f s (%.2f s finding them), %.0f replays/s, %.0f moves/s, "
+           "%d threads\n", entry_count, bad, (unsigned long long) moves, 
+           wall, indexed - start, entry_count / wall, moves / wall, 
+           thread_count);
+    if (other_engine != 0)
+        printf("%zu of them were recorded with another engine version and "
+               "still check out\n", other_engine);
+    return bad != 0;
+}
@@ -0,0 +1,59 @@
+//
+// anim.h - tiles sliding across the field
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#ifndef _ANIM_H
+#define _ANIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "board.h"
+
+// A move played over a few timer ticks. The game itself has moved on already,
+// this only draws the tiles of the board before it on their way. The spawn
+// and the merged tiles come with the full frame after the last one.
+struct anim_struct
+{
+    board_trace_t   trace;
+    uint32_t        start;      // tick it started on
+    uint32_t        frames;
+    bool            running;
+};
+typedef struct anim_struct anim_t;
+
+void    anim_start(anim_t* anim, const board_trace_t* trace, uint32_t tick, 
+                                                            uint32_t frames);
+
+// Jumps to the end, for when something else has to be shown right away
+void    anim_finish(anim_t* anim);
+
+// Draws and presents where the tiles are at tick. Returns false once the
+// animation is over, then it's up to the caller to draw the board.
+bool    anim_draw(anim_t* anim, uint32_t tick);
+
+#endif
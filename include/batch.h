@@ -0,0 +1,99 @@
+//
+// batch.h - many boards stepped at once
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+
+#ifndef _BATCH_H
+#define _BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "rng.h"
+
+// Boards are kept as a structure of arrays: row x of board i is rows[x][i].
+// A row is 16 bits, so one SIMD register holds the same row of 8 (SSE2) or
+// 16 (AVX2) boards and the whole batch moves with nibble tricks in 16-bit
+// lanes, no tables. Arrays are padded to BATCH_LANES boards.
+#define BATCH_LANES     16
+#define BATCH_ALIGN     32
+
+#define BATCH_KERNEL_SCALAR 0   /* board_move one board at a time */
+#define BATCH_KERNEL_VECTOR 1   /* plain C vectors, whatever the compiler does */
+#define BATCH_KERNEL_SSE2   2
+#define BATCH_KERNEL_AVX2   3
+#define BATCH_KERNEL_COUNT  4
+
+struct batch_struct
+{
+    size_t      count;
+    size_t      capacity;   // count rounded up to BATCH_LANES
+    uint16_t*   rows[4];
+    uint32_t*   scores;     // what every board scored in the last batch_move
+    uint16_t*   moved;      // 0xFFFF if the board changed in it, 0 if not
+};
+typedef struct batch_struct batch_t;
+
+// Bytes of memory batch_init needs for count boards
+size_t  batch_size(size_t count);
+
+// Lays the arrays out in mem (BATCH_ALIGN aligned, batch_size(count) bytes),
+// all boards are empty
+void    batch_init(batch_t* batch, void* mem, size_t count);
+
+static inline board_t batch_get(const batch_t* batch, size_t i)
+{
+    return (board_t) batch->rows[0][i] | 
+           ((board_t) batch->rows[1][i] << 16) | 
+           ((board_t) batch->rows[2][i] << 32) | 
+           ((board_t) batch->rows[3][i] << 48);
+}
+
+static inline void batch_set(batch_t* batch, size_t i, board_t board)
+{
+    for (int x = 0; x < 4; x++)
+        batch->rows[x][i] = (uint16_t) (board >> (x * 16));
+}
+
+// Moves every board in direction dir, boards that can't move stay as they
+// are. Sets scores and moved for every board.
+void    batch_move(batch_t* batch, int dir);
+
+// Puts a 2 or a 4 in a random empty cell of every board the last batch_move
+// moved, like a step of the game. The random numbers come from rng in 
+// blocks.
+void    batch_spawn(batch_t* batch, rng_t* rng);
+
+// Which kernel batch_move uses, batch_init picks the best the CPU has (after
+// cpu_init)
+bool        batch_set_kernel(int kernel);
+int         batch_kernel();
+const char* batch_kernel_name(int kernel);
+
+#endif
@@ -0,0 +1,213 @@
+//
+// board.h - packed 4x4 game board
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#ifndef _BOARD_H
+#define _BOARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rng.h"
+
+#define DIR_UP      0
+#define DIR_DOWN    1
+#define DIR_LEFT    2
+#define DIR_RIGHT   3
+#define DIR_COUNT   4
+
+// Ways board_move_all can be done
+#define BOARD_KERNEL_TABLE  0
+#define BOARD_KERNEL_SSE2   1
+#define BOARD_KERNEL_SSSE3  2
+#define BOARD_KERNEL_COUNT  3
+
+// The whole field fits in one 64-bit integer. Every cell is a 4-bit exponent
+// (0 is empty, 1 is 2, 2 is 4 and so on), data[x][y] of the game lives in
+// nibble x * 4 + y. So row x is bits 16x..16x+15 and inside a row the cell
+// with the lowest y is the lowest nibble.
+typedef uint64_t board_t;
+
+static inline int board_get(board_t board, int cell)
+{
+    return (int) (board >> (cell * 4)) & 0xF;
+}
+
+static inline board_t board_from_array(int data[4][4])
+{
+    board_t board = 0;
+    for (int x = 0; x < 4; x++)
+        for (int y = 0; y < 4; y++)
+            board |= (board_t) (data[x][y] & 0xF) << ((x * 4 + y) * 4);
+    return board;
+}
+
+static inline void board_to_array(board_t board, int data[4][4])
+{
+    for (int x = 0; x < 4; x++)
+        for (int y = 0; y < 4; y++)
+            data[x][y] = board_get(board, x * 4 + y);
+}
+
+// Swaps rows with columns, cell x * 4 + y ends up in y * 4 + x
+static inline board_t board_transpose(board_t x)
+{
+    board_t a1 = x & 0xF0F00F0FF0F00F0FULL;
+    board_t a2 = x & 0x0000F0F00000F0F0ULL;
+    board_t a3 = x & 0x0F0F00000F0F0000ULL;
+    board_t a  = a1 | (a2 << 12) | (a3 >> 12);
+    board_t b1 = a & 0xFF00FF0000FF00FFULL;
+    board_t b2 = a & 0x00FF00FF00000000ULL;
+    board_t b3 = a & 0x00000000FF00FF00ULL;
+    return b1 | (b2 >> 24) | (b3 << 24);
+}
+
+// Reverses the cells inside every row (left <-> right)
+static inline board_t board_mirror(board_t x)
+{
+    return ((x & 0x000F000F000F000FULL) << 12) |
+           ((x & 0x00F000F000F000F0ULL) << 4)  |
+           ((x & 0x0F000F000F000F00ULL) >> 4)  |
+           ((x & 0xF000F000F000F000ULL) >> 12);
+}
+
+// Reverses the order of the rows (top <-> bottom)
+static inline board_t board_flip(board_t x)
+{
+    return ((x & 0x000000000000FFFFULL) << 48) |
+           ((x & 0x00000000FFFF0000ULL) << 16) |
+           ((x & 0x0000FFFF00000000ULL) >> 16) |
+           ((x & 0xFFFF000000000000ULL) >> 48);
+}
+
+// Bit i is set if cell i is empty. Every nibble is ORed down into its lowest
+// bit, then the 16 lowest bits get folded together pairwise.
+static inline uint32_t board_empty_mask(board_t board)
+{
+    board_t x = board | (board >> 1);
+    x |= x >> 2;
+    x = ~x & 0x1111111111111111ULL;
+    x = (x | (x >> 3))  & 0x0303030303030303ULL;
+    x = (x | (x >> 6))  & 0x000F000F000F000FULL;
+    x = (x | (x >> 12)) & 0x000000FF000000FFULL;
+    x = (x | (x >> 24)) & 0xFFFF;
+    return (uint32_t) x;
+}
+
+// Set bits in a 16-bit mask, plain SWAR so it doesn't need POPCNT
+static inline int board_popcount16(uint32_t mask)
+{
+    mask = mask - ((mask >> 1) & 0x5555);
+    mask = (mask & 0x3333) + ((mask >> 2) & 0x3333);
+    mask = (mask + (mask >> 4)) & 0x0F0F;
+    return (int) ((mask + (mask >> 8)) & 0x1F);
+}
+
+// Position of the k-th (from 0) set bit in a 16-bit mask, k must be less than
+// the number of set bits. Halves the mask instead of walking the bits, which
+// the compiler turns into conditional moves.
+static inline int board_select_bit(uint32_t mask, int k)
+{
+    int pos = 0;
+    for (int width = 8; width > 0; width /= 2)
+    {
+        uint32_t low = mask & ((1u << width) - 1);
+        int count = board_popcount16(low);
+        int skip = k >= count;
+        k -= skip ? count : 0;
+        mask = skip ? mask >> width : low;
+        pos += skip ? width : 0;
+    }
+    return pos;
+}
+
+// Bit i (in the lowest bit of nibble i) is set if nibble i of x is 0
+static inline board_t board_zero_nibbles(board_t x)
+{
+    x |= x >> 1;
+    x |= x >> 2;
+    return ~x & 0x1111111111111111ULL;
+}
+
+// Fills the row lookup tables and picks the board_move_all kernel, has to be
+// called once (after cpu_init) before moving anything.
+void    board_init();
+
+// Moves all the tiles in direction dir (DIR_*), adds the merge score to *score
+// if score isn't 0. If nothing can move the same board is returned.
+board_t board_move(board_t board, int dir, uint32_t* score);
+
+// One tile in a move, cells are nibble numbers like everywhere else
+struct board_slide_struct
+{
+    uint8_t     from;
+    uint8_t     to;
+    uint8_t     tile;       // before the move
+    uint8_t     merged;     // whether another tile ended up in to as well
+};
+typedef struct board_slide_struct board_slide_t;
+
+// Where every tile of a board goes in one move, for animating it
+struct board_trace_struct
+{
+    int             count;
+    board_slide_t   slides[16];
+};
+typedef struct board_trace_struct board_trace_t;
+
+// board_move that also says where everything went. It has a table of its
+// own, so board_move doesn't get any slower for it.
+board_t board_trace(board_t board, int dir, board_trace_t* trace);
+
+typedef void (*board_move_all_f)(board_t board, board_t after[DIR_COUNT], 
+                                                    uint32_t score[DIR_COUNT]);
+
+// board_move in all four directions at once, after[dir] is the board and
+// score[dir] what it scores (not added to, unlike board_move). Points to the
+// fastest kernel the CPU has after board_init.
+extern board_move_all_f board_move_all;
+
+// Switches board_move_all to another kernel, false if the CPU can't do it
+bool        board_set_kernel(int kernel);
+int         board_kernel();
+const char* board_kernel_name(int kernel);
+
+// Is there any direction in which something moves? Doesn't move anything,
+// it just looks for an empty cell or two equal neighbours.
+bool    board_can_move(board_t board);
+
+// Puts a 2 (90%) or a 4 (10%) in a random empty cell, if there is one
+board_t board_spawn(board_t board, rng_t* rng);
+
+static inline int board_count_empty(board_t board)
+{
+    return board_popcount16(board_empty_mask(board));
+}
+
+int     board_max_tile(board_t board);
+
+#endif
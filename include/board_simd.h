@@ -0,0 +1,49 @@
+//
+// board_simd.h - SIMD move kernels for board.c
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+
+#ifndef _BOARD_SIMD_H
+#define _BOARD_SIMD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "board.h"
+
+// Builds the small score table, board_init calls it
+void    board_simd_init();
+
+// Both hold the 16 cells as bytes in an XMM register, one register per
+// direction. SSE2 turns the board around with the usual bit tricks, SSSE3
+// shuffles the bytes with pshufb and looks up the score with it too.
+void    board_move_all_sse2(board_t board, board_t after[DIR_COUNT], 
+                                                    uint32_t score[DIR_COUNT]);
+void    board_move_all_ssse3(board_t board, board_t after[DIR_COUNT], 
+                                                    uint32_t score[DIR_COUNT]);
+
+#endif
@@ -0,0 +1,76 @@
+//
+// cpu.h - what the CPU can do
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+
+#ifndef _CPU_H
+#define _CPU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Features that something here has a faster way for. Only what's usable is
+// set, AVX2 for example also needs the OS to save the YMM registers.
+#define CPU_SSE2            (1 << 0)
+#define CPU_SSSE3           (1 << 1)
+#define CPU_SSE41           (1 << 2)
+#define CPU_POPCNT          (1 << 3)
+#define CPU_BMI2            (1 << 4)
+#define CPU_AVX2            (1 << 5)
+#define CPU_RDRAND          (1 << 6)
+#define CPU_RDSEED          (1 << 7)
+#define CPU_INVARIANT_TSC   (1 << 8)
+#define CPU_APIC            (1 << 9)
+#define CPU_FEATURE_COUNT   10
+
+static inline void cpu_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+    asm volatile ("cpuid" 
+                  : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), 
+                    "=d" (regs[3]) 
+                  : "a" (leaf), "c" (subleaf));
+}
+
+// Runs CPUID once and remembers the answers. In the kernel it also turns on
+// SSE (and AVX if there is any), which has to happen before anything uses
+// them. Call it before any of the *_init functions that pick an
+// implementation by what the CPU has.
+void        cpu_init();
+
+uint32_t    cpu_features();
+const char* cpu_vendor();
+const char* cpu_feature_name(int bit);
+
+extern uint32_t _cpu_features;
+
+// Are all the features in the mask there?
+static inline bool cpu_has(uint32_t features)
+{
+    return (_cpu_features & features) == features;
+}
+
+#endif
@@ -0,0 +1,50 @@
+//
+// eval.h - static evaluation of positions for the AI
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#ifndef _EVAL_H
+#define _EVAL_H
+
+#include <stdbool.h>
+
+#include "board.h"
+#include "ntuple.h"
+
+// Builds the heuristic tables and picks the n-tuple kernel, call once after
+// board_init
+void    eval_init();
+
+// Use an n-tuple network instead of the heuristic, 0 goes back to the
+// heuristic. The network is not copied.
+void    eval_set_network(const ntuple_t* net);
+bool    eval_has_network();
+
+// How good the board is for the player who is about to get a new tile, in
+// roughly the units of the score. Higher is better.
+float   eval_board(board_t board);
+
+#endif
@@ -0,0 +1,64 @@
+//
+// game.h - the rules of 2048
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#ifndef _GAME_H
+#define _GAME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "rng.h"
+
+#define GAME_WIN_TILE   11  /* 2^11 = 2048 */
+
+// Goes into replays, bump it when moves, spawns or the rng change
+#define GAME_ENGINE_VERSION 1
+
+struct game_struct
+{
+    board_t     board;
+    uint64_t    score;
+    bool        won;
+    bool        lost;
+    rng_t       rng;
+};
+typedef struct game_struct game_t;
+
+// Starts a new game with two 2s, the rng is left as it is
+void    game_reset(game_t* game);
+
+// Moves in direction dir and spawns a new tile if anything moved.
+// Returns whether anything moved.
+bool    game_move(game_t* game, int dir);
+
+// Same as game_move, for when the move was already made somewhere else
+// (after and score are what board_move returned for the current board)
+bool    game_play(game_t* game, board_t after, uint32_t score);
+
+#endif
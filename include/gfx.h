@@ -0,0 +1,59 @@
+//
+// gfx.h - linear framebuffer graphics through Bochs VBE
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#ifndef _GFX_H
+#define _GFX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GFX_WIDTH   1024
+#define GFX_HEIGHT  768
+
+// A tile somewhere in the text mode field, in characters like _text_drawtile
+struct gfx_tile_struct
+{
+    uint8_t     row;
+    uint8_t     col;
+    uint8_t     tile;
+};
+typedef struct gfx_tile_struct gfx_tile_t;
+
+// Copies the VGA font while it's still there, switches to GFX_WIDTH x 
+// GFX_HEIGHT x 32 with the Bochs VBE interface and draws all the tiles once.
+// Has to be called in text mode, after cpu_init. False if there's no such
+// adapter, then nothing was touched.
+bool    gfx_init();
+
+bool    gfx_active();
+
+// Draws the 80x25 characters in cells, without the field, and the tiles
+// over the field. Only what's different from the last time gets drawn.
+void    gfx_present(const uint16_t* cells, const gfx_tile_t* tiles, int count);
+
+#endif
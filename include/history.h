@@ -0,0 +1,135 @@
+//
+// history.h - undo and redo
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+
+#ifndef _HISTORY_H
+#define _HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "game.h"
+#include "replay.h"
+#include "rng.h"
+
+// A ring of the last states of the game, one 16 byte entry per move. An entry
+// is the board after the move, what it added to the score and how many random
+// numbers it used, so going back is taking the board from the entry before,
+// the score back and the rng back (rng_advance can go backwards). Nothing
+// else is copied when a move is pushed.
+//
+// New games are entries too, so pressing R can be undone like a move. When
+// the ring is full the oldest entry goes to the replay writer, so the
+// replays have the game as it was played in the end: no undone moves.
+// history_sync keeps a copy of the writer going up to the current entry, so
+// there's always a replay of everything so far.
+
+#define HISTORY_START   DIR_COUNT   /* dir of an entry that starts a game */
+
+struct history_entry_struct
+{
+    board_t     board;          // after the move
+    int32_t     score;          // the move added, a new game takes it all away
+    uint16_t    draws;          // rng values the move (or game_reset) used
+    uint8_t     dir;            // or HISTORY_START
+    uint8_t     reserved;
+};
+typedef struct history_entry_struct history_entry_t;
+
+// The game right before some entry, as far as the replay is concerned
+struct history_tail_struct
+{
+    board_t     board;
+    uint64_t    score;
+    rng_t       rng;
+    bool        open;           // a replay has been started
+};
+typedef struct history_tail_struct history_tail_t;
+
+// Gets the replays, offset is where data goes in everything that was written
+// since history_init. A write makes whatever was after its offset worthless,
+// that's how undone moves and the end of a game that goes on are taken back.
+typedef void (*history_store_f)(void* ctx, uint32_t offset, const void* data, 
+                                size_t size);
+
+struct history_struct
+{
+    history_entry_t*    entries;
+    uint32_t            mask;
+    uint32_t            first;      // oldest entry, these only count up
+    uint32_t            current;    // the one the game is at
+    uint32_t            end;        // after the newest, redo goes up to it
+    
+    history_tail_t      tail;       // before entries[first]
+    replay_writer_t*    writer;     // 0 if nothing is recorded
+    history_store_f     store;
+    void*               ctx;
+    uint32_t            written;    // by writer, it goes on from here
+    
+    // the copy history_sync keeps going, it has the entries up to live_end
+    replay_writer_t     live;
+    history_tail_t      live_tail;
+    uint32_t            live_end;
+    uint32_t            live_written;
+    bool                live_valid; // false once entries it has are replaced
+};
+typedef struct history_struct history_t;
+
+// size has to be a power of 2. The replays go to writer and from there to
+// store with ctx.
+void    history_init(history_t* history, history_entry_t* entries, 
+                     uint32_t size, replay_writer_t* writer, 
+                     history_store_f store, void* ctx);
+
+// Remembers the state game is in now after dir (or HISTORY_START after
+// game_reset), rng and score are what the game had before. Anything that
+// could have been redone is gone.
+void    history_push(history_t* history, int dir, const rng_t* rng, 
+                     uint64_t score, const game_t* game);
+
+// Take back the last move or bring it back, false if there is none
+bool    history_undo(history_t* history, game_t* game);
+bool    history_redo(history_t* history, game_t* game);
+
+// The entry back moves ago (0 is the current one), 0 if it's not there
+// anymore. For looking at what would have happened with another move.
+const history_entry_t*  history_get(const history_t* history, uint32_t back);
+
+// Brings the copy of the writer up to the current entry and ends the replay
+// there, only the entries since the last time are written unless some of
+// those were undone. Call it after every push, undo and redo.
+void    history_sync(history_t* history);
+
+// Everything up to the current entry goes to the writer and the replay ends
+// there, it can't be undone anymore and there's nothing to redo. For when the
+// game's rng is seeded again, the replays can't go back past that.
+void    history_close(history_t* history);
+
+#endif
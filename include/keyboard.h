@@ -204,6 +204,7 @@ typedef uint8_t (*getscan_t)();
 typedef uint8_t (*readbyte_t)(bool*);
 typedef void (*wait_t)(void);
 typedef void (*waitack_t)(bool*, int*, int);
+typedef bool (*pending_t)(void);
 
 struct kb_interface_struct
 {
@@ -213,6 +214,7 @@ struct kb_interface_struct
     readbyte_t  readbyte;
     wait_t      wait;
     waitack_t   wait_ack;
+    pending_t   pending;    // are there scancodes waiting for getscan?
     bool        translated;
     
     // will be set by kb_add
@@ -224,8 +226,12 @@ struct kb_interface_struct
 typedef struct kb_interface_struct kb_interface_t;
 
 void    kb_add(kb_interface_t* interface);
+// Something else that input comes from (like COM1), it wakes kb_update up
+// and counts for kb_available but what it got has to be read from it
+void    kb_add_source(pending_t pending);
 void    kb_start();
-void    kb_update();
+void    kb_update();         // waits for a key if there's nothing to do
+bool    kb_available();      // would kb_update have something to do?
 const   char*   kb_getcharmap();
 
 bool    kb_ispressed(int key);
@@ -0,0 +1,120 @@
+//
+// multiboot.h - structures passed to us by a multiboot bootloader
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#ifndef _MULTIBOOT_H
+#define _MULTIBOOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// what the bootloader leaves in eax
+#define MULTIBOOT_BOOTLOADER_MAGIC  0x2BADB002
+
+// which fields of multiboot_info_t are valid
+#define MULTIBOOT_INFO_MEMORY       (1<<0)
+#define MULTIBOOT_INFO_BOOTDEV      (1<<1)
+#define MULTIBOOT_INFO_CMDLINE      (1<<2)
+#define MULTIBOOT_INFO_MODS         (1<<3)
+#define MULTIBOOT_INFO_MEM_MAP      (1<<6)
+#define MULTIBOOT_INFO_VBE_INFO     (1<<11)
+#define MULTIBOOT_INFO_FRAMEBUFFER  (1<<12)
+
+struct multiboot_module_struct
+{
+    uint32_t    mod_start;  // physical address of the first byte
+    uint32_t    mod_end;    // physical address right after the last byte
+    uint32_t    cmdline;    // char*, whatever was after the file in grub.cfg
+    uint32_t    reserved;
+}__attribute__((packed));
+typedef struct multiboot_module_struct multiboot_module_t;
+
+struct multiboot_info_struct
+{
+    uint32_t    flags;
+    
+    uint32_t    mem_lower;
+    uint32_t    mem_upper;
+    
+    uint32_t    boot_device;
+    
+    uint32_t    cmdline;
+    
+    uint32_t    mods_count;
+    uint32_t    mods_addr;  // multiboot_module_t[mods_count]
+    
+    uint32_t    syms[4];    // a.out or ELF symbols, we don't care
+    
+    uint32_t    mmap_length;
+    uint32_t    mmap_addr;
+    
+    uint32_t    drives_length;
+    uint32_t    drives_addr;
+    
+    uint32_t    config_table;
+    
+    uint32_t    boot_loader_name;
+    
+    uint32_t    apm_table;
+    
+    uint32_t    vbe_control_info;
+    uint32_t    vbe_mode_info;
+    uint16_t    vbe_mode;
+    uint16_t    vbe_interface_seg;
+    uint16_t    vbe_interface_off;
+    uint16_t    vbe_interface_len;
+    
+    uint64_t    framebuffer_addr;
+    uint32_t    framebuffer_pitch;
+    uint32_t    framebuffer_width;
+    uint32_t    framebuffer_height;
+    uint8_t     framebuffer_bpp;
+    uint8_t     framebuffer_type;
+    uint8_t     color_info[6];
+}__attribute__((packed));
+typedef struct multiboot_info_struct multiboot_info_t;
+
+void                        multiboot_init(uint32_t magic, 
+                                           multiboot_info_t* info);
+
+// Finds a module which has name as one of the words on its command line,
+// i.e. for "module /weights.ntw weights" name should be "weights".
+// Returns 0 if there is no such module or we weren't booted by multiboot.
+const multiboot_module_t*   multiboot_find_module(const char* name);
+
+// The next module with that name after prev, or the first one if prev is 0
+const multiboot_module_t*   multiboot_next_module(const char* name, 
+                                            const multiboot_module_t* prev);
+
+// Value of name=123 on the kernel command line, def if it isn't there
+uint32_t                    multiboot_cmdline_uint(const char* name, 
+                                                   uint32_t def);
+
+// Is word one of the words on the kernel command line, like "gfx"?
+bool                        multiboot_cmdline_has(const char* word);
+
+#endif
@@ -0,0 +1,133 @@
+//
+// ntuple.h - n-tuple network value function
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#ifndef _NTUPLE_H
+#define _NTUPLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board.h"
+
+// Weight file layout (little endian, which is all we run on anyways):
+//
+//  ntuple_header_t                     16 bytes
+//  ntuple_tuple_t[count]               8 bytes each
+//  zero padding up to weights_offset   (a multiple of 64)
+//  int16_t table[16^length] for every tuple, in the same order as the tuples
+//
+// A tuple's table is indexed by the exponents of its cells, the first cell
+// being the lowest nibble of the index. Every tuple is looked up in all 8
+// symmetries of the board and the looked up weights are summed; the sum is a
+// fixed point value with frac_bits fraction bits.
+//
+// The tables are used right where the bootloader (or mmap) put them, so the
+// writer should put the small tables first, they are the hot ones.
+
+#define NTUPLE_MAGIC        0x57544E41  /* "ANTW" */
+#define NTUPLE_VERSION      1
+
+#define NTUPLE_MAX_TUPLES   32
+#define NTUPLE_MAX_LENGTH   6   /* 16^6 weights is 32 MiB already */
+#define NTUPLE_ALIGN        64
+
+#define NTUPLE_OK           0
+#define NTUPLE_ERR_SIZE     -1  /* file is truncated */
+#define NTUPLE_ERR_MAGIC    -2  /* not a weight file */
+#define NTUPLE_ERR_VERSION  -3  /* written by something newer than us */
+#define NTUPLE_ERR_TUPLE    -4  /* bad tuple count, length or cells */
+#define NTUPLE_ERR_ALIGN    -5  /* misaligned weights */
+
+struct ntuple_header_struct
+{
+    uint32_t    magic;
+    uint16_t    version;
+    uint8_t     count;          // number of tuples
+    uint8_t     frac_bits;      // fixed point position of the summed weights
+    uint32_t    weights_offset; // from the start of the file
+    uint32_t    reserved;
+}__attribute__((packed));
+typedef struct ntuple_header_struct ntuple_header_t;
+
+struct ntuple_tuple_struct
+{
+    uint8_t     length;
+    uint8_t     cells[NTUPLE_MAX_LENGTH + 1];   // unused ones are 0
+}__attribute__((packed));
+typedef struct ntuple_tuple_struct ntuple_tuple_t;
+
+struct ntuple_struct
+{
+    int             count;
+    int             frac_bits;
+    size_t          weight_count;
+    const ntuple_tuple_t*   tuples;
+    const int16_t*  tables[NTUPLE_MAX_TUPLES];
+    
+    // for pext: the nibbles of every tuple, and where the upper half of the
+    // board starts in its index. Only if the cells of every tuple go up.
+    bool            ascending;
+    board_t         masks[NTUPLE_MAX_TUPLES];
+    uint8_t         high_shift[NTUPLE_MAX_TUPLES];
+};
+typedef struct ntuple_struct ntuple_t;
+
+// Checks the weight file in buf and points net at it, nothing is copied so
+// buf has to live as long as net is used.
+int         ntuple_map(ntuple_t* net, const void* buf, size_t size);
+const char* ntuple_strerror(int err);
+
+// Size of the table for a tuple of that length, in weights
+static inline size_t ntuple_table_size(int length)
+{
+    return (size_t) 1 << (length * 4);
+}
+
+// Index of a tuple in its table for a board
+static inline uint32_t ntuple_index(const ntuple_tuple_t* tuple, board_t board)
+{
+    uint32_t index = 0;
+    for (int i = 0; i < tuple->length; i++)
+        index |= (uint32_t) board_get(board, tuple->cells[i]) << (i * 4);
+    return index;
+}
+
+// Fills sym with the 8 rotations and reflections of board
+void        ntuple_symmetries(board_t board, board_t sym[8]);
+
+typedef int32_t (*ntuple_eval_f)(const ntuple_t* net, board_t board);
+
+// Value of board, fixed point with net->frac_bits fraction bits. Uses BMI2's
+// pext for the indices if the CPU has it, after ntuple_init.
+extern ntuple_eval_f ntuple_eval;
+
+// Picks the ntuple_eval implementation, call it after cpu_init
+void        ntuple_init();
+
+#endif
@@ -48,6 +48,7 @@
 #define _PIT_CHANNEL1_DATA          0x0041
 #define _PIT_CHANNEL2_DATA          0x0042
 #define _PIT_COMMAND_REGISTER       0x0043
+#define _PIT_FREQUENCY              1193182 /* Hz */
 
 #define _PIT_SELECT_CHAN0           0
 #define _PIT_SELECT_CHAN1           (1<<6)
@@ -82,6 +83,7 @@
 #define _PS2_KB_CONTROLLER_PORT_B   0x0061
 #define _PIT_CHAN2_GATE_ENABLE      (1<<0)
 #define _PS2_SPEAKER_DATA_ENABLE    (1<<1)
+#define _PIT_CHAN2_OUTPUT           (1<<5)  /* read only */
 #define _SPEAKER_ENABLE             3
 
 #define _PS2_REGISTER_PORT          0x0064  /* Write - command, Read - status */
@@ -122,18 +124,99 @@
 #define _PIC_SLAVE_COMMAND          0x00A0
 #define _PIC_SLAVE_DATA             0x00A1
 
+// 0x01CE - 0x01CF -- Bochs VBE (the "dispi" interface, also QEMU and VBox)
+#define _DISPI_INDEX_REGISTER       0x01CE
+#define _DISPI_DATA_REGISTER        0x01CF
+#define _DISPI_INDEX_ID             0x00
+#define _DISPI_INDEX_XRES           0x01
+#define _DISPI_INDEX_YRES           0x02
+#define _DISPI_INDEX_BPP            0x03
+#define _DISPI_INDEX_ENABLE         0x04
+#define _DISPI_ID_MIN               0xB0C0
+#define _DISPI_ID_32BPP             0xB0C2  /* first one with 32 bpp */
+#define _DISPI_ID_MAX               0xB0C5
+#define _DISPI_ENABLED              (1<<0)
+#define _DISPI_LFB_ENABLED          (1<<6)
+
+// 0x03C0 - 0x03CF -- EGA/VGA attribute controller, sequencer, graphics
+// controller, for the font in plane 2 and the timing of the text modes
+#define _VGA_ATTR_REGISTER          0x03C0  /* index and data, in turns */
+#define _VGA_ATTR_PANNING           0x13
+#define _VGA_ATTR_KEEP_VIDEO        (1<<5)  /* with the index */
+#define _VGA_MISC_WRITE             0x03C2
+#define _VGA_MISC_READ              0x03CC
+#define _VGA_MISC_SYNC_MASK         (3<<6)  /* the polarities pick the lines */
+#define _VGA_MISC_SYNC_480          (3<<6)
+#define _VGA_SEQ_SELECT_REGISTER    0x03C4
+#define _VGA_SEQ_DATA_REGISTER      0x03C5
+#define _VGA_SEQ_RESET              0x00
+#define _VGA_SEQ_RESET_SYNC         0x01
+#define _VGA_SEQ_RESET_RUN          0x03
+#define _VGA_SEQ_CLOCKING           0x01
+#define _VGA_SEQ_CLOCKING_8DOT      (1<<0)  /* 8 dots a character, not 9 */
+#define _VGA_SEQ_MAP_MASK           0x02
+#define _VGA_SEQ_MEMORY_MODE        0x04
+#define _VGA_GC_SELECT_REGISTER     0x03CE
+#define _VGA_GC_DATA_REGISTER       0x03CF
+#define _VGA_GC_READ_MAP            0x04
+#define _VGA_GC_MODE                0x05
+#define _VGA_GC_MISC                0x06
+
 // 0x03D0 - 0x3DF -- CGA (Color Graphics Adapter)
 #define _VGA_SELECT_REGISTER        0x03D4
+#define _VGA_REGISTER_MAXSCAN       0x09    /* low 5 bits, lines - 1 */
 #define _VGA_REGISTER_CURSORSTART   0x0A
 #define _VGA_DATA_CURSOROFF         (1<<5)
 #define _VGA_REGISTER_CURSOREND     0x0B
+#define _VGA_REGISTER_STARTHIGH     0x0C    /* where the screen starts, */
+#define _VGA_REGISTER_STARTLOW      0x0D    /* in characters */
 #define _VGA_REGISTER_CURSORLOCHIGH 0x0E
 #define _VGA_REGISTER_CURSORLOCLOW  0x0F
+#define _VGA_REGISTER_VRETRACE_END  0x11
+#define _VGA_DATA_PROTECT           (1<<7)  /* locks registers 0 - 7 */
 #define _VGA_DATA_REGISTER          0x03D5
+#define _VGA_INPUT_STATUS           0x03DA  /* Read only */
+#define _VGA_STATUS_RETRACE         (1<<3)  /* If set, in vertical retrace */
+
+// 0x03F8 - 0x03FF -- COM1 (16550 UART), the registers are relative to it
+#define _COM1_BASE                  0x03F8
+#define _UART_DATA                  0   /* THR write, RBR read */
+#define _UART_DIVISOR_LOW           0   /* with DLAB */
+#define _UART_INTERRUPT_ENABLE      1
+#define _UART_INT_RX_READY          (1<<0)
+#define _UART_DIVISOR_HIGH          1   /* with DLAB */
+#define _UART_INT_TX_EMPTY          (1<<1)
+#define _UART_INTERRUPT_ID          2   /* read only */
+#define _UART_FIFO_CONTROL          2   /* write only */
+#define _UART_FIFO_ENABLE           (1<<0)
+#define _UART_FIFO_CLEAR_RX         (1<<1)
+#define _UART_FIFO_CLEAR_TX         (1<<2)
+#define _UART_FIFO_TRIGGER_14       (3<<6)
+#define _UART_LINE_CONTROL          3
+#define _UART_8N1                   0x03
+#define _UART_DLAB                  (1<<7)
+#define _UART_MODEM_CONTROL         4
+#define _UART_MODEM_DTR             (1<<0)
+#define _UART_MODEM_RTS             (1<<1)
+#define _UART_MODEM_OUT2            (1<<3)  /* lets the IRQ through */
+#define _UART_MODEM_LOOPBACK        (1<<4)
+#define _UART_LINE_STATUS           5
+#define _UART_LINE_RX_READY         (1<<0)
+#define _UART_LINE_TX_EMPTY         (1<<5)  /* room for a FIFO's worth */
+#define _UART_CLOCK                 115200  /* the highest baud rate */
+#define _UART_FIFO_SIZE             16
+
+// 0x0CF8 - 0x0CFF -- PCI configuration space, mechanism #1
+#define _PCI_CONFIG_ADDRESS         0x0CF8
+#define _PCI_CONFIG_DATA            0x0CFC
+#define _PCI_CONFIG_ENABLE          (1<<31)
 
 uint8_t     inb (uint16_t port);
 uint16_t    inw (uint16_t port);
+uint32_t    inl (uint16_t port);
 void        outb(uint16_t port, uint8_t value);
+void        outw(uint16_t port, uint16_t value);
+void        outl(uint16_t port, uint32_t value);
 
 void        io_wait();
 
@@ -0,0 +1,145 @@
+//
+// remote.h - playing over the serial port
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#ifndef _REMOTE_H
+#define _REMOTE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game.h"
+
+// Frames go both ways as REMOTE_SYNC, payload length, command, payload and a
+// CRC-8 (polynomial 0x07) of length, command and payload. Numbers are little
+// endian. Whatever comes before a REMOTE_SYNC is skipped, so text printed by
+// the kernel before the first command doesn't get in the way.
+#define REMOTE_SYNC         0xA5
+#define REMOTE_MAX_PAYLOAD  255
+#define REMOTE_MAX_FRAME    (REMOTE_MAX_PAYLOAD + 4)
+
+// Commands, every one of them gets a REMOTE_REPLY_STATE back with how many
+// of its moves moved something (REMOTE_CMD_REPLAY a REMOTE_REPLY_REPLAY), or
+// a REMOTE_REPLY_ERROR
+#define REMOTE_CMD_STATE    0x01    /* nothing */
+#define REMOTE_CMD_MOVE     0x02    /* a DIR_* */
+#define REMOTE_CMD_RESET    0x03    /* nothing, or a uint64_t seed */
+#define REMOTE_CMD_BATCH    0x04    /* uint16_t count, then the DIR_*s */
+#define REMOTE_CMD_REPLAY   0x05    /* uint32_t offset */
+#define REMOTE_REPLY_STATE  0x81    /* remote_state_t */
+#define REMOTE_REPLY_REPLAY 0x82    /* remote_replay_t, then the bytes */
+#define REMOTE_REPLY_ERROR  0xFF    /* an int8_t REMOTE_ERR_* */
+
+// A batch has 4 moves a byte, the first one in the lowest 2 bits. It stops
+// early once the game is lost, moves that don't move anything are skipped.
+#define REMOTE_MAX_BATCH    ((REMOTE_MAX_PAYLOAD - 2) * 4)
+
+#define REMOTE_NONE         0   /* not a whole frame yet */
+#define REMOTE_FRAME        1   /* parser.frame is a good one */
+#define REMOTE_ERR_CHECKSUM -1  /* frame got garbled */
+#define REMOTE_ERR_COMMAND  -2  /* unknown command */
+#define REMOTE_ERR_LENGTH   -3  /* payload doesn't fit the command */
+#define REMOTE_ERR_DIR      -4  /* move isn't a DIR_* */
+
+#define REMOTE_WON          (1<<0)
+#define REMOTE_LOST         (1<<1)
+#define REMOTE_FULL         (1<<2)  /* games stopped being recorded */
+
+struct remote_state_struct
+{
+    board_t     board;
+    uint64_t    score;
+    uint16_t    applied;        // moves of the command that moved something
+    uint8_t     flags;          // REMOTE_WON, REMOTE_LOST, REMOTE_FULL
+}__attribute__((packed));
+typedef struct remote_state_struct remote_state_t;
+
+// The replays of all games since boot (see replay.h), one after another and
+// the one that's going on ended at its current move. They come up to
+// REMOTE_MAX_REPLAY bytes at a time from the offset in the command on, size
+// is how far they go. Once the kernel runs out of room REMOTE_FULL is set
+// and size stays after the last game that fit.
+struct remote_replay_struct
+{
+    uint32_t    offset;
+    uint32_t    size;           // of all of them
+    uint8_t     flags;          // REMOTE_FULL
+}__attribute__((packed));
+typedef struct remote_replay_struct remote_replay_t;
+
+#define REMOTE_MAX_REPLAY   (REMOTE_MAX_PAYLOAD - sizeof(remote_replay_t))
+
+struct remote_frame_struct
+{
+    uint8_t     command;
+    uint8_t     length;
+    uint8_t     payload[REMOTE_MAX_PAYLOAD];
+};
+typedef struct remote_frame_struct remote_frame_t;
+
+struct remote_parser_struct
+{
+    int             state;
+    int             have;       // payload bytes so far
+    uint8_t         crc;
+    remote_frame_t  frame;
+};
+typedef struct remote_parser_struct remote_parser_t;
+
+void        remote_parser_init(remote_parser_t* parser);
+
+// Takes the next byte that came in. Returns REMOTE_FRAME once a frame is
+// whole and makes sense, it's in parser->frame until the next byte. Frames
+// that don't are REMOTE_ERR_*, the parser goes on looking for the next one.
+// Replies parse the same, only the checks for commands are left out.
+int         remote_feed(remote_parser_t* parser, uint8_t byte);
+
+// Puts a frame into out, returns how long it is
+size_t      remote_encode(uint8_t command, const void* payload, size_t length, 
+                          uint8_t out[REMOTE_MAX_FRAME]);
+
+// The payload of a REMOTE_CMD_BATCH, count has to be REMOTE_MAX_BATCH at most
+size_t      remote_pack_batch(const uint8_t* dirs, int count, 
+                              uint8_t payload[REMOTE_MAX_PAYLOAD]);
+
+static inline int remote_batch_count(const remote_frame_t* frame)
+{
+    return frame->payload[0] | (frame->payload[1] << 8);
+}
+
+static inline int remote_batch_dir(const remote_frame_t* frame, int i)
+{
+    return (frame->payload[2 + i / 4] >> ((i % 4) * 2)) & 3;
+}
+
+void        remote_state(const game_t* game, int applied, 
+                         remote_state_t* state);
+
+const char* remote_strerror(int err);
+
+#endif
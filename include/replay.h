@@ -0,0 +1,190 @@
+//
+// replay.h - recorded games
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+
+#ifndef _REPLAY_H
+#define _REPLAY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "game.h"
+#include "rng.h"
+
+// Replay layout (little endian like the weight files):
+//
+//  replay_header_t                     32 bytes
+//  one byte per move                   direction, spawned cell and value
+//  replay_checkpoint_t                 24 bytes after every interval moves
+//  replay_end_t                        21 bytes, starts with REPLAY_END
+//
+// A move byte is dir | cell << 2 | (value - 1) << 6, value being the spawned
+// exponent (1 or 2), so the top bit is never set and REPLAY_END can't be a
+// move. The header has the rng state from before game_reset, that and the
+// moves are enough to play the game again; the spawns are in there so it
+// can be checked that the rng really gave them. Checkpoints have everything
+// needed to start in the middle. Replays can simply be put one after another
+// in a file, the end of one is where the next one starts.
+//
+// A 300 move game is about 380 bytes.
+
+#define REPLAY_MAGIC        0x4C505241  /* "ARPL" */
+#define REPLAY_VERSION      1
+#define REPLAY_INTERVAL     256         /* moves between checkpoints */
+#define REPLAY_END          0xFF
+
+#define REPLAY_OK           0
+#define REPLAY_DONE         1   /* not an error, the game is over */
+#define REPLAY_ERR_SIZE     -1  /* replay is truncated */
+#define REPLAY_ERR_MAGIC    -2  /* not a replay */
+#define REPLAY_ERR_VERSION  -3  /* written by something newer than us */
+#define REPLAY_ERR_CORRUPT  -4  /* bad move byte or checkpoint */
+#define REPLAY_ERR_ILLEGAL  -5  /* a move that doesn't move anything */
+#define REPLAY_ERR_SPAWN    -6  /* the rng spawned something else */
+#define REPLAY_ERR_STATE    -7  /* game differs from a checkpoint or the end */
+
+struct replay_header_struct
+{
+    uint32_t    magic;
+    uint16_t    version;
+    uint16_t    engine;         // GAME_ENGINE_VERSION of the writer
+    uint16_t    interval;       // moves between checkpoints
+    uint16_t    reserved[3];
+    uint64_t    state;          // the game's rng before game_reset
+    uint64_t    inc;
+}__attribute__((packed));
+typedef struct replay_header_struct replay_header_t;
+
+struct replay_checkpoint_struct
+{
+    board_t     board;
+    uint64_t    score;
+    uint64_t    state;          // inc is still the one from the header
+}__attribute__((packed));
+typedef struct replay_checkpoint_struct replay_checkpoint_t;
+
+struct replay_end_struct
+{
+    uint8_t     marker;         // REPLAY_END
+    uint32_t    moves;
+    board_t     board;
+    uint64_t    score;
+}__attribute__((packed));
+typedef struct replay_end_struct replay_end_t;
+
+// Gets the replay a few bytes at a time, whatever it's going to
+typedef void (*replay_write_f)(void* ctx, const void* data, size_t size);
+
+#define REPLAY_BUFFER_SIZE  256
+
+struct replay_writer_struct
+{
+    replay_write_f  write;
+    void*           ctx;
+    uint32_t        moves;
+    uint32_t        used;
+    uint8_t         buffer[REPLAY_BUFFER_SIZE];
+};
+typedef struct replay_writer_struct replay_writer_t;
+
+// Starts a replay, rng has to be the game's rng right before game_reset
+void    replay_begin(replay_writer_t* writer, replay_write_f write, void* ctx, 
+                     const rng_t* rng);
+
+// Records a move, before is the board before it and game is after it (so
+// after game_move or game_play returned true)
+void    replay_record(replay_writer_t* writer, board_t before, int dir, 
+                      const game_t* game);
+
+// Writes the end and hands over what's still buffered
+void    replay_finish(replay_writer_t* writer, const game_t* game);
+
+struct replay_move_struct
+{
+    int         dir;
+    int         cell;
+    int         value;          // exponent of the spawned tile
+};
+typedef struct replay_move_struct replay_move_t;
+
+struct replay_reader_struct
+{
+    const uint8_t*  data;
+    size_t          size;
+    size_t          pos;        // the next move byte, or the end
+    uint16_t        engine;
+    uint16_t        interval;
+    rng_t           rng;        // from the header
+    uint32_t        moves;      // read so far
+    replay_end_t    end;        // once replay_next returned REPLAY_DONE
+};
+typedef struct replay_reader_struct replay_reader_t;
+
+// Checks the header, nothing is copied so data has to stay around. size can
+// be more than the replay, once it's done reader->pos is where it ended.
+int     replay_open(replay_reader_t* reader, const void* data, size_t size);
+
+// The next move, REPLAY_DONE at the end
+int     replay_next(replay_reader_t* reader, replay_move_t* move);
+
+// Sets up game for the start of the replay
+void    replay_start(const replay_reader_t* reader, game_t* game);
+
+// Makes the next move in game and checks that it spawned the recorded tile.
+// The game is checked against every checkpoint it passes and the end.
+int     replay_step(replay_reader_t* reader, game_t* game);
+
+// Goes to the game right after move (0 is the start) from the closest
+// checkpoint before it. REPLAY_DONE if the game ended before that.
+int     replay_seek(replay_reader_t* reader, game_t* game, uint32_t move);
+
+// Bytes the replay at data takes, without playing it. 0 if it can't be read
+// to the end.
+size_t  replay_length(const void* data, size_t size);
+
+// What replay_verify found out
+struct replay_check_struct
+{
+    int         err;            // REPLAY_OK if everything checked out
+    uint32_t    moves;          // that did, so move moves + 1 is the bad one
+    uint64_t    score;          // of the game as it was played again
+    uint16_t    engine;         // version that recorded it
+    size_t      size;           // bytes the replay took, if it was readable
+};
+typedef struct replay_check_struct replay_check_t;
+
+// Plays the replay at data again as fast as possible: nothing but the moves
+// and the spawns, every spawn, checkpoint and the end are checked. Returns
+// check->err.
+int     replay_verify(const void* data, size_t size, replay_check_t* check);
+
+const char* replay_strerror(int err);
+
+#endif
@@ -0,0 +1,84 @@
+//
+// rng.h - pseudo random numbers for the game
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#ifndef _RNG_H
+#define _RNG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// PCG32 (XSH RR), see pcg-random.org. Every game (and every trainer thread)
+// has its own generator so nothing shares state. Generators seeded with the
+// same seed but different streams give independent sequences.
+struct rng_struct
+{
+    uint64_t    state;
+    uint64_t    inc;        // always odd, picks the stream
+};
+typedef struct rng_struct rng_t;
+
+#define RNG_MULTIPLIER  6364136223846793005ULL
+
+void        rng_seed(rng_t* rng, uint64_t seed);
+void        rng_seed_stream(rng_t* rng, uint64_t seed, uint64_t stream);
+
+// 32 random bits
+static inline uint32_t rng_next(rng_t* rng)
+{
+    uint64_t old = rng->state;
+    rng->state = old * RNG_MULTIPLIER + rng->inc;
+    uint32_t xorshifted = (uint32_t) (((old >> 18) ^ old) >> 27);
+    uint32_t rot = (uint32_t) (old >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+// Uniform in [0, n), n must not be 0. Lemire's multiply and reject, it
+// almost never needs a second value and never divides in the common case.
+static inline uint32_t rng_below(rng_t* rng, uint32_t n)
+{
+    uint64_t m = (uint64_t) rng_next(rng) * n;
+    uint32_t low = (uint32_t) m;
+    if (low < n)
+    {
+        uint32_t threshold = -n % n;
+        while (low < threshold)
+        {
+            m = (uint64_t) rng_next(rng) * n;
+            low = (uint32_t) m;
+        }
+    }
+    return (uint32_t) (m >> 32);
+}
+
+// Fills buf with count values, the same ones count rng_next calls would give
+void        rng_fill(rng_t* rng, uint32_t* buf, size_t count);
+
+// Jumps delta values ahead in log(delta) steps, a negative delta goes back
+void        rng_advance(rng_t* rng, int64_t delta);
+
+#endif
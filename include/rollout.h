@@ -0,0 +1,86 @@
+//
+// rollout.h - Monte Carlo rollout player
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+
+#ifndef _ROLLOUT_H
+#define _ROLLOUT_H
+
+#include <stdint.h>
+
+#include "board.h"
+#include "rng.h"
+
+// Every legal first move is followed by a number of games of random moves,
+// the move with the best average score wins. No tree, so it's only as
+// strong as the number of random steps per second, but the rollouts don't
+// depend on each other and split across cores without any locking.
+
+struct rollout_limits_struct
+{
+    uint32_t    rollouts;   // per first move
+    uint32_t    depth;      // moves per rollout at most, 0 is until it's over
+};
+typedef struct rollout_limits_struct rollout_limits_t;
+
+// What some rollouts added up to. Every worker has its own, they only come
+// together in rollout_finish.
+struct rollout_sums_struct
+{
+    uint64_t    score[DIR_COUNT];
+    uint64_t    steps;
+};
+typedef struct rollout_sums_struct rollout_sums_t;
+
+struct rollout_result_struct
+{
+    int         dir;                // -1 if nothing can move
+    float       value;              // average score of dir's rollouts
+    float       values[DIR_COUNT];
+    uint32_t    rollouts;           // in total
+    uint64_t    steps;              // random moves in all of them
+    uint32_t    us;
+};
+typedef struct rollout_result_struct rollout_result_t;
+
+// Plays count rollouts for every legal first move from board and adds them to
+// sums (which rollout_clear has to have cleared). Workers that each do a share
+// of limits->rollouts need their own rng and sums.
+void    rollout_clear(rollout_sums_t* sums);
+void    rollout_work(board_t board, const rollout_limits_t* limits, 
+                     uint32_t count, rng_t* rng, rollout_sums_t* sums);
+
+// Adds up the sums of all workers and picks the move
+void    rollout_finish(board_t board, const rollout_limits_t* limits, 
+                       const rollout_sums_t* sums, int workers, 
+                       rollout_result_t* result);
+
+// All of it on this core
+void    rollout_run(board_t board, const rollout_limits_t* limits, rng_t* rng, 
+                    rollout_result_t* result);
+
+#endif
@@ -0,0 +1,130 @@
+//
+// search.h - expectimax search for the AI
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#ifndef _SEARCH_H
+#define _SEARCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "rng.h"
+
+#define SEARCH_MAX_DEPTH        16
+#define SEARCH_CHECK_INTERVAL   64      /* nodes between deadline checks */
+#define SEARCH_GROWTH           4       /* don't start a depth that won't */
+                                        /* finish, assuming it takes this */
+                                        /* many times longer than the last */
+
+typedef bool (*search_abort_f)(void);
+
+struct search_limits_struct
+{
+    uint32_t    budget_us;      // 0 means no deadline
+    int         max_depth;      // in moves, at most SEARCH_MAX_DEPTH
+    
+    // A spawn that is less likely than this to happen at all (all the
+    // spawns on the way to it multiplied) isn't searched any further, it
+    // just gets evaluated. 0 searches everything.
+    float       min_prob;
+    
+    // If there are more empty cells than this only that many random ones
+    // are looked at when a tile spawns. 0 looks at all of them.
+    int         sample_cells;
+    
+    // Polled as often as the deadline, the search stops when it returns
+    // true. 0 if it doesn't matter.
+    search_abort_f abort;
+};
+typedef struct search_limits_struct search_limits_t;
+
+struct search_result_struct
+{
+    int         dir;            // best move, -1 if there is none
+    float       value;
+    int         depth;          // deepest iteration that completed
+    uint32_t    nodes;
+    uint32_t    cutoffs;        // spawns evaluated because of min_prob
+    uint32_t    us;             // time it took
+    
+    // every root move, after[dir] == the searched board if dir can't move
+    board_t     after[DIR_COUNT];
+    uint32_t    reward[DIR_COUNT];
+    float       values[DIR_COUNT];  // from the deepest completed iteration
+};
+typedef struct search_result_struct search_result_t;
+
+// Transposition table entry, for afterstates. If min_prob cut off anything
+// below it the value is only good for nodes about as unlikely as the one
+// it came from (or less likely), rarity is -log2 of that one's probability
+// then. Otherwise it's 0 and the value is good anywhere.
+struct search_entry_struct
+{
+    board_t     board;
+    float       value;
+    int8_t      depth;
+    uint8_t     rarity;
+    uint16_t    generation;     // entries from another one are empty
+};
+typedef struct search_entry_struct search_entry_t;
+
+struct search_struct
+{
+    search_entry_t* table;
+    uint32_t        mask;
+    uint16_t        generation; // of the entries that count, never 0
+    
+    uint64_t        deadline;   // TSC, 0 when there's none
+    search_abort_f  abort;
+    float           min_prob;
+    int             sample_cells;
+    uint32_t        nodes;
+    uint32_t        cutoffs;
+    bool            aborted;
+    rng_t           rng;        // for picking the sampled cells
+};
+typedef struct search_struct search_t;
+
+// table_size has to be a power of two. The table is kept between searches
+// so positions that come up again are already there.
+void    search_init(search_t* search, search_entry_t* table, 
+                                                        uint32_t table_size);
+
+// Forgets everything in the table. It's only a new generation, so it's
+// cheap, the table only gets cleared for real once every 65535 of them.
+void    search_clear(search_t* search);
+
+// Deepens one move at a time until the budget or max_depth runs out and
+// returns the result of the deepest search that completed. The table is
+// cleared when min_prob or sample_cells aren't the ones from last time. Depth 1 always
+// completes (neither the deadline nor abort are checked there), so there's
+// always a move if the game isn't lost.
+void    search_run(search_t* search, board_t board, 
+                    const search_limits_t* limits, search_result_t* result);
+
+#endif
@@ -0,0 +1,59 @@
+//
+// serial.h - COM1 output
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#ifndef _SERIAL_H
+#define _SERIAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Sets COM1 up for baud 8N1 with FIFOs and IRQ 4 for both ways, after 
+// irq_init. Whatever was written before is sent then. False if there's no 
+// UART, then everything written is dropped.
+bool    serial_init(uint32_t baud);
+
+// Queues a byte to be sent, never waits for the UART. If the queue is full
+// the byte is dropped.
+void    serial_putc(char c);
+
+void    serial_write(const void* data, size_t size);
+
+// Whether something came in that serial_read hasn't taken yet
+bool    serial_pending();
+
+// The next byte that came in, false if there's none. Never waits.
+bool    serial_read(uint8_t* byte);
+
+// IRQ 4, takes what came in and refills the transmit FIFO from the queue
+void    serial_irq();
+
+// bytes dropped because the queue was full
+size_t  serial_dropped();
+
+#endif
@@ -39,24 +39,62 @@
 
 #ifdef __kernel__
 
-void _text_drawfield(int[4][4], bool, bool, uint64_t, uint64_t);
+#include "board.h"
+
+void _text_drawfield(board_t, bool, bool, uint64_t, uint64_t);
+void _text_drawai(const char*, int, int, uint32_t, uint32_t, bool);
+// Frames and characters copied a frame, moves and AI nodes over the last 
+// second, under the instructions. Only in the modes with room for it.
+void _text_drawdash(uint32_t fps, uint32_t moves, uint32_t nodes, 
+                    uint32_t cells);
+// characters written to text memory since the last call
+uint32_t _text_copied();
+// A frame with the tiles somewhere else than in the last _text_drawfield,
+// everything else stays. Only what the tiles covered gets drawn again.
+void _text_beginslide();
+// A tile at a character row and column of the field, between cells is fine
+void _text_drawtile(int row, int col, int tile);
 void _text_init();
+// 50 (80x50) or 60 (90x60) lines instead of 25, while the console is still
+// up and not with graphics. False if it stays 80x25.
+bool _text_mode(int rows);
+// Shows what was drawn since the last one from the next vertical retrace
+// on. If the one before is still waiting for its retrace this waits for it.
+void _text_present();
+// Whether _text_present would go right through
+bool _text_ready();
+// Measures how long a frame is, after tsc_init. Returns the refresh rate in
+// Hz. Until then every flip is waited for.
+uint32_t _text_refresh_init();
 void _text_switchstyle();
+// Switches to the graphics in gfx.c for good if the adapter can do it, false
+// if it stays text. Everything still gets drawn the same way.
+bool _text_graphics();
 
 #endif
 
 #define EOF 0x7E
 
-// Temporary
-#define stdout ((FILE *) 0)
-#define stderr ((FILE *) 0)
+// Where the characters of a stream go, any of these
+#define _STREAM_VGA     (1<<0)
+#define _STREAM_SERIAL  (1<<1)
 
 //TODO
 typedef struct FILE_struct
 {
-    
+    int     targets;
 } FILE;
 
+// Both go to the screen and COM1 unless the command line says otherwise,
+// _screen is only the screen, for drawing the game
+extern FILE _stdout;
+extern FILE _stderr;
+extern FILE _stdscreen;
+
+#define stdout  (&_stdout)
+#define stderr  (&_stderr)
+#define _screen (&_stdscreen)
+
 int fprintf(FILE *restrict, const char *restrict, ...);
 int fputc(int c, FILE* stream);
 int fputs(const char *restrict s, FILE *restrict stream);
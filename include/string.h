@@ -49,4 +49,9 @@ void *memmove(void *s1, const void *s2, size_t n);
 // of the first n bytes of the object pointed to by s.
 void *memset(void *s, int c, size_t n);
 
+// NOT STANDARD
+// Picks the fastest way to copy memory the CPU has, call after cpu_init.
+// Until then everything is copied byte by byte.
+void _string_init();
+
 #endif
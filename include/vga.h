@@ -0,0 +1,51 @@
+//
+// vga.h - text modes and the font of the VGA
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#ifndef _VGA_H
+#define _VGA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// lines of a character in the font left by the firmware
+#define VGA_FONT_HEIGHT     16
+
+// Copies the 256 characters of the font in plane 2, the first height lines
+// of each, a byte a line
+void    vga_read_font(uint8_t* glyphs, int height);
+
+// The other way, the lines from height on are cleared
+void    vga_write_font(const uint8_t* glyphs, int height);
+
+// Switches the 80x25 text mode the firmware left to cols x rows, 80x50 or
+// 90x60 (80x25 is left as it is). Those get an 8x8 font made from the 8x16
+// one. Returns the lines of a character, 0 for anything else and then 
+// nothing was touched.
+int     vga_text_mode(int cols, int rows);
+
+#endif
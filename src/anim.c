@@ -0,0 +1,84 @@
+//
+// anim.c - tiles sliding across the field
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "anim.h"
+#include "board.h"
+#include "stdio.h"
+
+// where cell x * 4 + y is on the screen, see _text_drawfield
+#define CELL_ROW(cell)  (1 + ((cell) / 4) * 2)
+#define CELL_COL(cell)  (1 + ((cell) % 4) * 5)
+
+void anim_start(anim_t* anim, const board_trace_t* trace, uint32_t tick, 
+                                                            uint32_t frames)
+{
+    anim->trace = *trace;
+    anim->start = tick;
+    anim->frames = frames;
+    anim->running = frames > 0;
+}
+
+void anim_finish(anim_t* anim)
+{
+    anim->running = false;
+}
+
+bool anim_draw(anim_t* anim, uint32_t tick)
+{
+    // the first frame is already on its way, the last one is the board
+    uint32_t step = tick - anim->start + 1;
+    if (!anim->running || step >= anim->frames)
+    {
+        anim->running = false;
+        return false;
+    }
+    
+    _text_beginslide();
+    // the ones that stay put first, so the moving ones go over them
+    for (int moving = 0; moving < 2; moving++)
+    {
+        for (int i = 0; i < anim->trace.count; i++)
+        {
+            const board_slide_t* slide = &anim->trace.slides[i];
+            if ((slide->from != slide->to) != moving)
+                continue;
+            int row = CELL_ROW(slide->from);
+            int col = CELL_COL(slide->from);
+            row += (CELL_ROW(slide->to) - row) * (int) step / 
+                                                        (int) anim->frames;
+            col += (CELL_COL(slide->to) - col) * (int) step / 
+                                                        (int) anim->frames;
+            _text_drawtile(row, col, slide->tile);
+        }
+    }
+    _text_present();
+    return true;
+}
@@ -0,0 +1,332 @@
+//
+// batch.c - implementation of batch.h
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "batch.h"
+#include "board.h"
+#include "cpu.h"
+#include "rng.h"
+
+// 16 rows of 16 boards, GCC splits it into two registers without AVX2
+typedef uint16_t lanes_t __attribute__((vector_size(32)));
+typedef uint32_t wide_t __attribute__((vector_size(64)));
+typedef int32_t wide_int_t __attribute__((vector_size(64)));
+typedef float wide_float_t __attribute__((vector_size(64)));
+
+#define INLINE  static inline __attribute__((always_inline))
+
+// Lowest bit of every nibble of x that is 0. Macros and pointers instead of
+// passing lanes_t around, GCC complains about the ABI of that even when it
+// all gets inlined.
+#define ZERO_NIBBLES(x) (~((x) | ((x) >> 1) | ((x) >> 2) | ((x) >> 3)) & 0x1111)
+
+
+INLINE void reverse(lanes_t* x)
+{
+    *x = (*x >> 12) | ((*x >> 4) & 0x00F0) | ((*x << 4) & 0x0F00) | (*x << 12);
+}
+
+// everything from the first empty nibble on moves down by one
+INLINE void compact(lanes_t* x)
+{
+    lanes_t empty = ZERO_NIBBLES(*x) * 0xF;
+    empty |= empty << 4;
+    empty |= empty << 8;
+    *x = (empty & (*x >> 4)) | (~empty & *x);
+}
+
+// Slides and merges every row towards nibble 0, the same thing row_left in
+// board.c does with a table and slide in board_simd.c with bytes. Adds the
+// score to *score.
+INLINE void slide(lanes_t* row, wide_t* score)
+{
+    lanes_t x = *row;
+    compact(&x);
+    compact(&x);
+    compact(&x);
+    
+    // equal to the next one, not empty and not 15 (those don't merge)
+    lanes_t full = x & (x >> 1) & (x >> 2) & (x >> 3) & 0x1111;
+    lanes_t diff = x ^ (x >> 4);
+    lanes_t equal = ZERO_NIBBLES(diff) & ~ZERO_NIBBLES(x) & ~full & 0x0111;
+    // merge from the front: a cell merges if the one before it doesn't
+    lanes_t first = equal & ~(equal << 4);
+    lanes_t merge = equal & ~(first << 4);
+    
+    // 2^(v + 1) for every merge. There's no variable shift for 16-bit lanes
+    // (nor for 32-bit ones before AVX2), but a float with the exponent
+    // v + 1 converted to an integer is the same thing. 0 bits are 0.0.
+    for (int k = 0; k < 3; k++)
+    {
+        lanes_t merged = (merge >> (k * 4)) & 1;
+        lanes_t exponent = (((x >> (k * 4)) & 0xF) + 1 + 127) * merged;
+        wide_t bits = __builtin_convertvector(exponent, wide_t) << 23;
+        *score += (wide_t) __builtin_convertvector((wide_float_t) bits, 
+                                                                wide_int_t);
+    }
+    
+    x += merge;
+    x &= ~((merge * 0xF) << 4);
+    // merged pairs are never next to each other, one step fills the holes
+    compact(&x);
+    *row = x;
+}
+
+// nibble c of row x becomes nibble x of column c and back
+INLINE void transpose(lanes_t in[4], lanes_t out[4])
+{
+    for (int c = 0; c < 4; c++)
+    {
+        out[c] = ((in[0] >> (c * 4)) & 0xF) | 
+                 (((in[1] >> (c * 4)) & 0xF) << 4) | 
+                 (((in[2] >> (c * 4)) & 0xF) << 8) | 
+                 (((in[3] >> (c * 4)) & 0xF) << 12);
+    }
+}
+
+// BATCH_LANES boards starting at i
+INLINE void move_lanes(batch_t* batch, size_t i, int dir)
+{
+    lanes_t rows[4];
+    for (int x = 0; x < 4; x++)
+        rows[x] = *(const lanes_t*) (batch->rows[x] + i);
+    
+    lanes_t lines[4];
+    if (dir == DIR_UP || dir == DIR_DOWN)
+        transpose(rows, lines);
+    else
+        for (int x = 0; x < 4; x++)
+            lines[x] = rows[x];
+    
+    wide_t score = {0};
+    bool back = dir == DIR_DOWN || dir == DIR_RIGHT;
+    for (int x = 0; x < 4; x++)
+    {
+        if (back)
+            reverse(&lines[x]);
+        slide(&lines[x], &score);
+        if (back)
+            reverse(&lines[x]);
+    }
+    
+    lanes_t out[4];
+    if (dir == DIR_UP || dir == DIR_DOWN)
+        transpose(lines, out);
+    else
+        for (int x = 0; x < 4; x++)
+            out[x] = lines[x];
+    
+    lanes_t moved = {0};
+    for (int x = 0; x < 4; x++)
+    {
+        moved |= (lanes_t) (out[x] != rows[x]);
+        *(lanes_t*) (batch->rows[x] + i) = out[x];
+    }
+    *(lanes_t*) (batch->moved + i) = moved;
+    *(wide_t*) (batch->scores + i) = score;
+}
+
+// The same code three times, the target decides what the vectors become
+static void move_vector(batch_t* batch, int dir)
+{
+    for (size_t i = 0; i < batch->capacity; i += BATCH_LANES)
+        move_lanes(batch, i, dir);
+}
+
+__attribute__((target("sse2")))
+static void move_sse2(batch_t* batch, int dir)
+{
+    for (size_t i = 0; i < batch->capacity; i += BATCH_LANES)
+        move_lanes(batch, i, dir);
+}
+
+__attribute__((target("avx2")))
+static void move_avx2(batch_t* batch, int dir)
+{
+    for (size_t i = 0; i < batch->capacity; i += BATCH_LANES)
+        move_lanes(batch, i, dir);
+}
+
+static void move_scalar(batch_t* batch, int dir)
+{
+    for (size_t i = 0; i < batch->count; i++)
+    {
+        board_t board = batch_get(batch, i);
+        uint32_t score = 0;
+        board_t after = board_move(board, dir, &score);
+        batch_set(batch, i, after);
+        batch->scores[i] = score;
+        batch->moved[i] = after != board ? 0xFFFF : 0;
+    }
+}
+
+static const struct
+{
+    const char* name;
+    uint32_t    needs;  // CPU_*
+    void        (*move)(batch_t* batch, int dir);
+} kernels[BATCH_KERNEL_COUNT] = {
+    {"scalar", 0,        move_scalar},
+    {"vector", 0,        move_vector},
+    {"sse2",   CPU_SSE2, move_sse2},
+    {"avx2",   CPU_AVX2, move_avx2},
+};
+
+static int kernel_used = -1;
+
+bool batch_set_kernel(int kernel)
+{
+    if (kernel < 0 || kernel >= BATCH_KERNEL_COUNT || 
+                                                !cpu_has(kernels[kernel].needs))
+        return false;
+    kernel_used = kernel;
+    return true;
+}
+
+int batch_kernel()
+{
+    return kernel_used;
+}
+
+const char* batch_kernel_name(int kernel)
+{
+    if (kernel < 0 || kernel >= BATCH_KERNEL_COUNT)
+        return "?";
+    return kernels[kernel].name;
+}
+
+static size_t round_up(size_t n, size_t to)
+{
+    return (n + to - 1) / to * to;
+}
+
+size_t batch_size(size_t count)
+{
+    size_t capacity = round_up(count, BATCH_LANES);
+    return capacity * (4 * sizeof(uint16_t) + sizeof(uint32_t) + 
+                                                            sizeof(uint16_t));
+}
+
+void batch_init(batch_t* batch, void* mem, size_t count)
+{
+    if (kernel_used < 0)
+        for (int kernel = BATCH_KERNEL_COUNT - 1; kernel >= 0; kernel--)
+            if (batch_set_kernel(kernel))
+                break;
+    
+    batch->count = count;
+    batch->capacity = round_up(count, BATCH_LANES);
+    // every array is a multiple of 32 bytes, so they all stay aligned
+    uint8_t* p = mem;
+    batch->scores = (uint32_t*) p;
+    p += batch->capacity * sizeof(uint32_t);
+    for (int x = 0; x < 4; x++)
+    {
+        batch->rows[x] = (uint16_t*) p;
+        p += batch->capacity * sizeof(uint16_t);
+    }
+    batch->moved = (uint16_t*) p;
+    
+    for (size_t i = 0; i < batch->capacity; i++)
+    {
+        batch_set(batch, i, 0);
+        batch->scores[i] = 0;
+        batch->moved[i] = 0;
+    }
+}
+
+void batch_move(batch_t* batch, int dir)
+{
+    if (dir < 0 || dir >= DIR_COUNT)
+        return;
+    kernels[kernel_used].move(batch, dir);
+}
+
+#define SPAWN_BLOCK 256
+
+// rng_below on numbers that were made in advance, what's left of the last
+// block is thrown away
+struct spawn_rng_struct
+{
+    rng_t*      rng;
+    uint32_t    values[SPAWN_BLOCK];
+    int         next;
+};
+
+static uint32_t spawn_next(struct spawn_rng_struct* r)
+{
+    if (r->next == SPAWN_BLOCK)
+    {
+        rng_fill(r->rng, r->values, SPAWN_BLOCK);
+        r->next = 0;
+    }
+    return r->values[r->next++];
+}
+
+static uint32_t spawn_below(struct spawn_rng_struct* r, uint32_t n)
+{
+    uint64_t m = (uint64_t) spawn_next(r) * n;
+    uint32_t low = (uint32_t) m;
+    if (low < n)
+    {
+        uint32_t threshold = -n % n;
+        while (low < threshold)
+        {
+            m = (uint64_t) spawn_next(r) * n;
+            low = (uint32_t) m;
+        }
+    }
+    return (uint32_t) (m >> 32);
+}
+
+void batch_spawn(batch_t* batch, rng_t* rng)
+{
+    struct spawn_rng_struct r;
+    r.rng = rng;
+    r.next = SPAWN_BLOCK;
+    
+    for (size_t i = 0; i < batch->count; i++)
+    {
+        // a move that didn't move anything doesn't get a tile either
+        if (!batch->moved[i])
+            continue;
+        board_t board = batch_get(batch, i);
+        uint32_t mask = board_empty_mask(board);
+        if (mask == 0)
+            continue;
+        // the same as board_spawn
+        uint32_t value = spawn_below(&r, board_popcount16(mask) * 10);
+        int cell = board_select_bit(mask, value / 10);
+        uint16_t tile = (value % 10) ? 1 : 2;
+        batch->rows[cell / 4][i] |= tile << ((cell % 4) * 4);
+    }
+}
@@ -0,0 +1,275 @@
+//
+// board.c - moving tiles around on a packed board
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "board_simd.h"
+#include "cpu.h"
+#include "rng.h"
+
+// Every row is only 16 bits, so all the moving is done once here and looked
+// up later. Columns are rows of the transposed board.
+static uint16_t row_left[65536];
+static uint16_t row_right[65536];
+static uint32_t row_score[65536];   // what moving the row left scores
+// Where every tile of the row goes moving left, 2 bits per cell from the
+// lowest one, and in bits 8-11 which cells got merged into
+static uint16_t row_trace[65536];
+
+static uint16_t reverse_row(uint16_t row)
+{
+    return (row >> 12) | ((row >> 4) & 0x00F0) | ((row << 4) & 0x0F00) | 
+                                                                    (row << 12);
+}
+
+void board_init()
+{
+    for (uint32_t row = 0; row < 65536; row++)
+    {
+        int line[4];
+        for (int i = 0; i < 4; i++)
+            line[i] = (row >> (i * 4)) & 0xF;
+        
+        int out[4] = {0, 0, 0, 0};
+        int count = 0;
+        bool merged = false;    // so 2 2 4 becomes 4 4 and not 8
+        uint32_t score = 0;
+        uint16_t trace = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            if (line[i] == 0)
+                continue;
+            // 15 is as far as a nibble goes, so those just don't merge
+            if (count > 0 && !merged && out[count - 1] == line[i] && 
+                                                                line[i] != 15)
+            {
+                out[count - 1]++;
+                score += 1 << out[count - 1];
+                merged = true;
+                trace |= (count - 1) << (i * 2);
+                trace |= 1 << (8 + count - 1);
+            }
+            else
+            {
+                out[count] = line[i];
+                trace |= count << (i * 2);
+                count++;
+                merged = false;
+            }
+        }
+        
+        row_left[row] = out[0] | (out[1] << 4) | (out[2] << 8) | (out[3] << 12);
+        row_score[row] = score;
+        row_trace[row] = trace;
+    }
+    
+    for (uint32_t row = 0; row < 65536; row++)
+        row_right[row] = reverse_row(row_left[reverse_row(row)]);
+    
+    board_simd_init();
+    for (int kernel = BOARD_KERNEL_COUNT - 1; kernel >= 0; kernel--)
+        if (board_set_kernel(kernel))
+            break;
+}
+
+static board_t move_left(board_t board, uint32_t* score)
+{
+    board_t ret = 0;
+    for (int x = 0; x < 4; x++)
+    {
+        uint16_t row = board >> (x * 16);
+        ret |= (board_t) row_left[row] << (x * 16);
+        *score += row_score[row];
+    }
+    return ret;
+}
+
+static board_t move_right(board_t board, uint32_t* score)
+{
+    board_t ret = 0;
+    for (int x = 0; x < 4; x++)
+    {
+        uint16_t row = board >> (x * 16);
+        ret |= (board_t) row_right[row] << (x * 16);
+        *score += row_score[reverse_row(row)];
+    }
+    return ret;
+}
+
+board_t board_move(board_t board, int dir, uint32_t* score)
+{
+    uint32_t tmp = 0;
+    board_t ret;
+    switch (dir)
+    {
+        case DIR_UP:
+            ret = board_transpose(move_left(board_transpose(board), &tmp));
+            break;
+        case DIR_DOWN:
+            ret = board_transpose(move_right(board_transpose(board), &tmp));
+            break;
+        case DIR_LEFT:
+            ret = move_left(board, &tmp);
+            break;
+        case DIR_RIGHT:
+            ret = move_right(board, &tmp);
+            break;
+        default:
+            return board;
+    }
+    if (score != 0)
+        *score += tmp;
+    return ret;
+}
+
+board_t board_trace(board_t board, int dir, board_trace_t* trace)
+{
+    trace->count = 0;
+    for (int line = 0; line < 4; line++)
+    {
+        // the cells of the line in the order they move in, so it's always
+        // a move to the left
+        int cells[4];
+        uint16_t row = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            switch (dir)
+            {
+                case DIR_UP:    cells[i] = i * 4 + line;        break;
+                case DIR_DOWN:  cells[i] = (3 - i) * 4 + line;  break;
+                case DIR_LEFT:  cells[i] = line * 4 + i;        break;
+                default:        cells[i] = line * 4 + 3 - i;    break;
+            }
+            row |= board_get(board, cells[i]) << (i * 4);
+        }
+        
+        uint16_t moves = row_trace[row];
+        for (int i = 0; i < 4; i++)
+        {
+            int tile = (row >> (i * 4)) & 0xF;
+            if (tile == 0)
+                continue;
+            int to = (moves >> (i * 2)) & 3;
+            board_slide_t* slide = &trace->slides[trace->count++];
+            slide->from = cells[i];
+            slide->to = cells[to];
+            slide->tile = tile;
+            slide->merged = (moves >> (8 + to)) & 1;
+        }
+    }
+    return board_move(board, dir, 0);
+}
+
+static void move_all_table(board_t board, board_t after[DIR_COUNT], 
+                                                    uint32_t score[DIR_COUNT])
+{
+    board_t transposed = board_transpose(board);
+    for (int dir = 0; dir < DIR_COUNT; dir++)
+        score[dir] = 0;
+    after[DIR_UP] = board_transpose(move_left(transposed, &score[DIR_UP]));
+    after[DIR_DOWN] = board_transpose(move_right(transposed, 
+                                                        &score[DIR_DOWN]));
+    after[DIR_LEFT] = move_left(board, &score[DIR_LEFT]);
+    after[DIR_RIGHT] = move_right(board, &score[DIR_RIGHT]);
+}
+
+static const struct
+{
+    const char*         name;
+    uint32_t            needs;  // CPU_*
+    board_move_all_f    move_all;
+} kernels[BOARD_KERNEL_COUNT] = {
+    {"table", 0,                     move_all_table},
+    {"sse2",  CPU_SSE2,              board_move_all_sse2},
+    {"ssse3", CPU_SSE2 | CPU_SSSE3,  board_move_all_ssse3},
+};
+
+static int kernel_used = BOARD_KERNEL_TABLE;
+board_move_all_f board_move_all = move_all_table;
+
+bool board_set_kernel(int kernel)
+{
+    if (kernel < 0 || kernel >= BOARD_KERNEL_COUNT || 
+                                                !cpu_has(kernels[kernel].needs))
+        return false;
+    kernel_used = kernel;
+    board_move_all = kernels[kernel].move_all;
+    return true;
+}
+
+int board_kernel()
+{
+    return kernel_used;
+}
+
+const char* board_kernel_name(int kernel)
+{
+    if (kernel < 0 || kernel >= BOARD_KERNEL_COUNT)
+        return "?";
+    return kernels[kernel].name;
+}
+
+bool board_can_move(board_t board)
+{
+    // with an empty cell somewhere some tile can always slide into it,
+    // unless there are no tiles at all
+    board_t empty = board_zero_nibbles(board);
+    // 15s don't merge, there's no nibble for 16
+    board_t full = board & (board >> 1) & (board >> 2) & (board >> 3) & 
+                                                        0x1111111111111111ULL;
+    // nibble i equal to the one on its right (i + 1) or below it (i + 4)
+    board_t rows = board_zero_nibbles(board ^ (board >> 4)) & 
+                                                        0x0111011101110111ULL;
+    board_t cols = board_zero_nibbles(board ^ (board >> 16)) & 
+                                                        0x0000111111111111ULL;
+    return board != 0 && ((empty | ((rows | cols) & ~full)) != 0);
+}
+
+board_t board_spawn(board_t board, rng_t* rng)
+{
+    uint32_t mask = board_empty_mask(board);
+    if (mask == 0)
+        return board;
+    
+    // one value for both the cell and the tile, 2 with 90%, 4 with 10%
+    uint32_t r = rng_below(rng, board_popcount16(mask) * 10);
+    int cell = board_select_bit(mask, r / 10);
+    board_t tile = (r % 10) ? 1 : 2;
+    return board | (tile << (cell * 4));
+}
+
+int board_max_tile(board_t board)
+{
+    int max = 0;
+    for (int i = 0; i < 16; i++)
+        if (board_get(board, i) > max)
+            max = board_get(board, i);
+    return max;
+}
@@ -0,0 +1,193 @@
+//
+// board_simd.c - implementation of board_simd.h
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "board_simd.h"
+
+// Only vector extensions and builtins, the intrinsics headers want a libc
+typedef unsigned char       v16u8 __attribute__((vector_size(16)));
+typedef char                v16i8 __attribute__((vector_size(16)));
+typedef short               v8i16 __attribute__((vector_size(16)));
+typedef unsigned short      v8u16 __attribute__((vector_size(16)));
+typedef unsigned int        v4u32 __attribute__((vector_size(16)));
+typedef long long           v2i64 __attribute__((vector_size(16)));
+typedef unsigned long long  v2u64 __attribute__((vector_size(16)));
+
+#define SSE2    __attribute__((target("sse2")))
+#define SSSE3   __attribute__((target("ssse3")))
+#define INLINE  static inline __attribute__((always_inline))
+
+// nibble i of the board becomes byte i
+INLINE SSE2 v16u8 unpack(board_t board)
+{
+    v2u64 v = {board, 0};
+    v2u64 low = v & 0x0F0F0F0F0F0F0F0FULL;
+    v2u64 high = (v >> 4) & 0x0F0F0F0F0F0F0F0FULL;
+    return (v16u8) __builtin_ia32_punpcklbw128((v16i8) low, (v16i8) high);
+}
+
+INLINE SSE2 board_t pack(v16u8 cells)
+{
+    v8u16 pairs = (v8u16) cells;
+    pairs = (pairs | (pairs >> 4)) & 0x00FF;
+    v2u64 packed = (v2u64) __builtin_ia32_packuswb128((v8i16) pairs, 
+                                                            (v8i16) pairs);
+    return packed[0];
+}
+
+// One step of sliding towards byte 0 of every 4 byte row: from the first
+// empty cell on everything moves down by one.
+INLINE SSE2 v16u8 compact(v16u8 cells)
+{
+    v4u32 empty = (v4u32) (cells == 0);
+    empty |= empty << 8;
+    empty |= empty << 16;
+    v4u32 next = (v4u32) cells >> 8;
+    return (v16u8) ((empty & next) | (~empty & (v4u32) cells));
+}
+
+// Everything in every row goes towards byte 0 and merges, the same thing
+// row_left in board.c does with a table.
+INLINE SSE2 v16u8 slide(v16u8 cells)
+{
+    // 3 steps get any row of 4 tight
+    cells = compact(cells);
+    cells = compact(cells);
+    cells = compact(cells);
+    
+    // cells equal to their neighbour, empty cells and 15s don't count
+    v16u8 next = (v16u8) ((v4u32) cells >> 8);
+    v16u8 equal = (v16u8) (cells == next) & ~(v16u8) (cells == 0) & 
+                                                    ~(v16u8) (cells == 15);
+    // merge from the front, so 2 2 2 becomes 4 2 and 2 2 2 2 becomes 4 4:
+    // a cell merges if it's equal and the one before it doesn't merge
+    v16u8 first = equal & ~(v16u8) ((v4u32) equal << 8);
+    v16u8 merge = equal & ~(v16u8) ((v4u32) first << 8);
+    
+    cells -= merge;     // merge is 0xFF, so that's + 1
+    cells &= ~(v16u8) ((v4u32) merge << 8);
+    // merged pairs are never next to each other, one step fills the holes
+    return compact(cells);
+}
+
+// The score of a board is what it took to build all its tiles from 2s,
+// (v - 1) * 2^v for a tile 2^v. A move scores the difference. This is the
+// worth of two cells, one byte of the board.
+static uint32_t pair_worth[256];
+
+void board_simd_init()
+{
+    for (int i = 0; i < 256; i++)
+    {
+        int low = i & 0xF;
+        int high = i >> 4;
+        pair_worth[i] = (low ? (uint32_t) (low - 1) << low : 0) + 
+                        (high ? (uint32_t) (high - 1) << high : 0);
+    }
+}
+
+static uint32_t worth(board_t board)
+{
+    uint32_t sum = 0;
+    for (int i = 0; i < 8; i++)
+        sum += pair_worth[(board >> (i * 8)) & 0xFF];
+    return sum;
+}
+
+SSE2 void board_move_all_sse2(board_t board, board_t after[DIR_COUNT], 
+                                                    uint32_t score[DIR_COUNT])
+{
+    board_t transposed = board_transpose(board);
+    v16u8 up = slide(unpack(transposed));
+    v16u8 down = slide(unpack(board_mirror(transposed)));
+    v16u8 left = slide(unpack(board));
+    v16u8 right = slide(unpack(board_mirror(board)));
+    
+    after[DIR_UP] = board_transpose(pack(up));
+    after[DIR_DOWN] = board_transpose(board_mirror(pack(down)));
+    after[DIR_LEFT] = pack(left);
+    after[DIR_RIGHT] = board_mirror(pack(right));
+    
+    uint32_t before = worth(board);
+    for (int dir = 0; dir < DIR_COUNT; dir++)
+        score[dir] = worth(after[dir]) - before;
+}
+
+// byte i of the result is byte order[i] of cells
+INLINE SSSE3 v16u8 shuffle(v16u8 cells, v16u8 order)
+{
+    return (v16u8) __builtin_ia32_pshufb128((v16i8) cells, (v16i8) order);
+}
+
+// the worth of every cell in three bytes, summed with psadbw
+INLINE SSSE3 uint32_t worth_ssse3(v16u8 cells)
+{
+    static const v16u8 worth0 = {0x00, 0x00, 0x04, 0x10, 0x30, 0x80, 0x40, 
+                        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    static const v16u8 worth1 = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 
+                        0x03, 0x07, 0x10, 0x24, 0x50, 0xB0, 0x80, 0x40, 0x00};
+    static const v16u8 worth2 = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+                        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x03, 0x07};
+    const v16i8 zero = {0};
+    v2i64 sum = __builtin_ia32_psadbw128((v16i8) shuffle(worth0, cells), zero) + 
+        (__builtin_ia32_psadbw128((v16i8) shuffle(worth1, cells), zero) << 8) + 
+        (__builtin_ia32_psadbw128((v16i8) shuffle(worth2, cells), zero) << 16);
+    return (uint32_t) (sum[0] + sum[1]);
+}
+
+SSSE3 void board_move_all_ssse3(board_t board, board_t after[DIR_COUNT], 
+                                                    uint32_t score[DIR_COUNT])
+{
+    // cell x * 4 + y, see board.h
+    static const v16u8 transpose = {0, 4, 8, 12, 1, 5, 9, 13, 
+                                    2, 6, 10, 14, 3, 7, 11, 15};
+    static const v16u8 mirror = {3, 2, 1, 0, 7, 6, 5, 4, 
+                                 11, 10, 9, 8, 15, 14, 13, 12};
+    static const v16u8 down = {12, 8, 4, 0, 13, 9, 5, 1, 
+                               14, 10, 6, 2, 15, 11, 7, 3};
+    static const v16u8 undown = {3, 7, 11, 15, 2, 6, 10, 14, 
+                                 1, 5, 9, 13, 0, 4, 8, 12};
+    
+    v16u8 cells = unpack(board);
+    v16u8 moved[DIR_COUNT];
+    moved[DIR_UP] = shuffle(slide(shuffle(cells, transpose)), transpose);
+    moved[DIR_DOWN] = shuffle(slide(shuffle(cells, down)), undown);
+    moved[DIR_LEFT] = slide(cells);
+    moved[DIR_RIGHT] = shuffle(slide(shuffle(cells, mirror)), mirror);
+    
+    uint32_t before = worth_ssse3(cells);
+    for (int dir = 0; dir < DIR_COUNT; dir++)
+    {
+        after[dir] = pack(moved[dir]);
+        score[dir] = worth_ssse3(moved[dir]) - before;
+    }
+}
@@ -24,13 +24,14 @@
 ; SOFTWARE.
 ; 
 
-;MBOOT_PAGE_ALIGN    equ 1<<0       ;   all modules on page boundaries
-                                    ;   doesn't matter since we don't use paging
-                                    ;   and don't have any modules
+MBOOT_PAGE_ALIGN    equ 1<<0        ;   all modules on page boundaries
+                                    ;   we don't page, but the n-tuple weights
+                                    ;   module is used in place, so it's nice
+                                    ;   to have it aligned
 ;MBOOT_MEM_INFO      equ 1<<1       ;   we don't need meminfo since we don't use
                                     ;   dynamic memory
 MBOOT_HEADER_MAGIC  equ 0x1BADB002  ;   multiboot standard special magic code
-MBOOT_HEADER_FLAGS  equ 0           ;   MBOOT_PAGE_ALIGN | MBOOT_MEM_INFO
+MBOOT_HEADER_FLAGS  equ MBOOT_PAGE_ALIGN
 MBOOT_CHECKSUM      equ -(MBOOT_HEADER_MAGIC + MBOOT_HEADER_FLAGS)
 
 [BITS 32]                           ;   We use 32 bits since there's no real
@@ -57,10 +58,10 @@ mboot:                              ;   here we put down all the flags
 [EXTERN main]
 
 start:
-    ; push ebx                      ; since we didn't pass MBOOT_MEM_INFO
-                                    ; we don't need this
-    
     cli                             ; disable interrupts
+    push ebx                        ; multiboot info, we need it for modules
+    push eax                        ; multiboot magic, so we know ebx is legit
+    fninit                          ; the AI does its math in floats
     call main
     jmp $                           ; in case we exit from main (we shouldn't)
                                     ; we have an infinite loop here
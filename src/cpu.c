@@ -0,0 +1,147 @@
+//
+// cpu.c - implementation of cpu.h
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cpu.h"
+
+uint32_t _cpu_features;
+static char vendor[13];
+
+static const char* feature_names[CPU_FEATURE_COUNT] = {
+    "sse2", "ssse3", "sse4.1", "popcnt", "bmi2", "avx2", "rdrand", "rdseed", 
+    "invariant-tsc", "apic",
+};
+
+#ifdef __kernel__
+// SSE instructions fault until CR4.OSFXSR says the OS knows about them, AVX
+// ones until XCR0 says the same. Nothing here switches tasks, so there's no
+// state to save and this is all.
+static void enable_sse(bool avx)
+{
+    uint32_t cr;
+    asm volatile ("mov %%cr0, %0" : "=r" (cr));
+    cr &= ~(1 << 2);            // EM, no x87 emulation
+    cr |= 1 << 1;               // MP
+    asm volatile ("mov %0, %%cr0" : : "r" (cr));
+    asm volatile ("mov %%cr4, %0" : "=r" (cr));
+    cr |= (1 << 9) | (1 << 10); // OSFXSR, OSXMMEXCPT
+    if (avx)
+        cr |= 1 << 18;          // OSXSAVE
+    asm volatile ("mov %0, %%cr4" : : "r" (cr));
+    if (avx)
+        asm volatile ("xsetbv" : : "c" (0), "a" (7), "d" (0));  // x87 SSE AVX
+}
+#endif
+
+void cpu_init()
+{
+    uint32_t regs[4];
+    cpu_cpuid(0, 0, regs);
+    uint32_t max_leaf = regs[0];
+    ((uint32_t*) vendor)[0] = regs[1];
+    ((uint32_t*) vendor)[1] = regs[3];
+    ((uint32_t*) vendor)[2] = regs[2];
+    vendor[12] = 0;
+    
+    uint32_t features = 0;
+    cpu_cpuid(1, 0, regs);
+    uint32_t ecx = regs[2];
+    uint32_t edx = regs[3];
+    bool sse = (edx >> 25) & 1;
+    bool avx = ((ecx >> 26) & 1) && ((ecx >> 28) & 1);   // XSAVE, AVX
+#ifdef __kernel__
+    if (sse)
+    {
+        enable_sse(avx);
+        cpu_cpuid(1, 0, regs);  // for OSXSAVE
+        ecx = regs[2];
+    }
+#endif
+    if (sse && ((edx >> 26) & 1))
+        features |= CPU_SSE2;
+    if ((ecx >> 9) & 1)
+        features |= CPU_SSSE3;
+    if ((ecx >> 19) & 1)
+        features |= CPU_SSE41;
+    if ((ecx >> 23) & 1)
+        features |= CPU_POPCNT;
+    if ((ecx >> 30) & 1)
+        features |= CPU_RDRAND;
+    if ((edx >> 9) & 1)
+        features |= CPU_APIC;
+    
+    // the YMM registers have to be switched on (OSXSAVE) and saved (XCR0)
+    bool ymm = false;
+    if (avx && ((ecx >> 27) & 1))
+    {
+        uint32_t low, high;
+        asm volatile ("xgetbv" : "=a" (low), "=d" (high) : "c" (0));
+        ymm = (low & 6) == 6;
+    }
+    
+    if (max_leaf >= 7)
+    {
+        cpu_cpuid(7, 0, regs);
+        if ((regs[1] >> 8) & 1)
+            features |= CPU_BMI2;
+        if (((regs[1] >> 5) & 1) && ymm)
+            features |= CPU_AVX2;
+        if ((regs[1] >> 18) & 1)
+            features |= CPU_RDSEED;
+    }
+    
+    cpu_cpuid(0x80000000, 0, regs);
+    if (regs[0] >= 0x80000007)
+    {
+        cpu_cpuid(0x80000007, 0, regs);
+        if ((regs[3] >> 8) & 1)
+            features |= CPU_INVARIANT_TSC;
+    }
+    
+    _cpu_features = features;
+}
+
+uint32_t cpu_features()
+{
+    return _cpu_features;
+}
+
+const char* cpu_vendor()
+{
+    return vendor;
+}
+
+const char* cpu_feature_name(int bit)
+{
+    if (bit < 0 || bit >= CPU_FEATURE_COUNT)
+        return "?";
+    return feature_names[bit];
+}
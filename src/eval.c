@@ -0,0 +1,131 @@
+//
+// eval.c - implementation of eval.h
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "eval.h"
+#include "ntuple.h"
+
+// the hand tuned heuristic, scored per row and per column
+#define HEUR_BASE           200000.0f
+#define HEUR_EMPTY          270.0f
+#define HEUR_MERGES         700.0f
+#define HEUR_MONOTONICITY   47.0f
+#define HEUR_SUM            11.0f
+
+static float row_heur[65536];
+
+static const ntuple_t* network;
+static float network_scale;
+
+void eval_init()
+{
+    ntuple_init();
+    for (uint32_t row = 0; row < 65536; row++)
+    {
+        int line[4];
+        for (int i = 0; i < 4; i++)
+            line[i] = (row >> (i * 4)) & 0xF;
+        
+        float sum = 0;
+        int empty = 0;
+        int merges = 0;
+        int prev = 0;
+        int counter = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            int rank = line[i];
+            sum += rank * rank * rank;
+            if (rank == 0)
+            {
+                empty++;
+                continue;
+            }
+            if (prev == rank)
+            {
+                counter++;
+            }
+            else if (counter > 0)
+            {
+                merges += 1 + counter;
+                counter = 0;
+            }
+            prev = rank;
+        }
+        if (counter > 0)
+            merges += 1 + counter;
+        
+        // how far off the row is from going up or going down
+        float left = 0;
+        float right = 0;
+        for (int i = 1; i < 4; i++)
+        {
+            float a = line[i - 1] * line[i - 1];
+            float b = line[i] * line[i];
+            a *= a;
+            b *= b;
+            if (line[i - 1] > line[i])
+                left += a - b;
+            else
+                right += b - a;
+        }
+        
+        row_heur[row] = HEUR_BASE + HEUR_EMPTY * empty + HEUR_MERGES * merges -
+                HEUR_MONOTONICITY * (left < right ? left : right) - 
+                HEUR_SUM * sum;
+    }
+}
+
+void eval_set_network(const ntuple_t* net)
+{
+    network = net;
+    if (net != 0)
+        network_scale = 1.0f / (1 << net->frac_bits);
+}
+
+bool eval_has_network()
+{
+    return network != 0;
+}
+
+float eval_board(board_t board)
+{
+    if (network != 0)
+        return ntuple_eval(network, board) * network_scale;
+    
+    board_t t = board_transpose(board);
+    float value = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        value += row_heur[(uint16_t) (board >> (i * 16))];
+        value += row_heur[(uint16_t) (t >> (i * 16))];
+    }
+    return value;
+}
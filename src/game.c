@@ -0,0 +1,67 @@
+//
+// game.c - implementation of game.h
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "game.h"
+#include "rng.h"
+
+void game_reset(game_t* game)
+{
+    // two different cells, the second one skips over the first
+    int a = rng_below(&game->rng, 16);
+    int b = rng_below(&game->rng, 15);
+    if (b >= a)
+        b++;
+    game->board = ((board_t) 1 << (a * 4)) | ((board_t) 1 << (b * 4));
+    game->score = 0;
+    game->won = false;
+    game->lost = false;
+}
+
+bool game_move(game_t* game, int dir)
+{
+    uint32_t score = 0;
+    board_t moved = board_move(game->board, dir, &score);
+    return game_play(game, moved, score);
+}
+
+bool game_play(game_t* game, board_t after, uint32_t score)
+{
+    if (after == game->board)
+        return false;
+    
+    game->board = board_spawn(after, &game->rng);
+    game->score += score;
+    if (board_max_tile(game->board) >= GAME_WIN_TILE)
+        game->won = true;
+    game->lost = !board_can_move(game->board);
+    return true;
+}
@@ -0,0 +1,339 @@
+//
+// gfx.c - linear framebuffer graphics through Bochs VBE
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cpu.h"
+#include "gfx.h"
+#include "ports.h"
+#include "string.h"
+#include "vga.h"
+
+// Where the adapter's framebuffer usually is if PCI doesn't say
+#define LFB_DEFAULT     0xE0000000
+
+// The tiles are drawn once into sprites, the board is their background
+#define TILE            96
+#define GAP             8
+#define BOARD_X         16
+#define BOARD_Y         16
+#define BOARD_SIZE      (4 * TILE + 5 * GAP)
+#define BOARD_COLOR     0xBBADA0
+
+// The text screen minus the field (the first 21 columns of the first 9 rows,
+// see _text_drawfield): the rest of those rows goes right of the board and
+// everything under them goes under it.
+#define TEXT_WIDTH      80
+#define TEXT_HEIGHT     25
+#define FIELD_COLS      21
+#define FIELD_ROWS      9
+#define TEXT_RIGHT_X    (BOARD_X + BOARD_SIZE + 16)
+#define TEXT_BELOW_Y    (BOARD_Y + BOARD_SIZE + 16)
+
+#define GLYPH_WIDTH     8
+#define GLYPH_HEIGHT    VGA_FONT_HEIGHT
+
+// where a tile at a character row and column of the field goes, cells are 5
+// columns and 2 rows apart starting at 1
+#define TILE_X(col)     (BOARD_X + GAP + ((col) - 1) * (TILE + GAP) / 5)
+#define TILE_Y(row)     (BOARD_Y + GAP + ((row) - 1) * (TILE + GAP) / 2)
+
+typedef unsigned int v4u32 __attribute__((vector_size(16)));
+// framebuffer rows aren't 16 byte aligned everywhere
+typedef unsigned int v4u32u __attribute__((vector_size(16), aligned(4)));
+
+#define SSE2    __attribute__((target("sse2")))
+
+static const uint32_t palette[16] = {
+    0x000000, 0x0000AA, 0x00AA00, 0x00AAAA, 0xAA0000, 0xAA00AA, 0xAA5500, 
+    0xAAAAAA, 0x555555, 0x5555FF, 0x55FF55, 0x55FFFF, 0xFF5555, 0xFF55FF, 
+    0xFFFF55, 0xFFFFFF
+};
+
+// like the original game, 2 to 2048 and then the same for everything above
+static const uint32_t tile_colors[16] = {
+    BOARD_COLOR, 0xEEE4DA, 0xEDE0C8, 0xF2B179, 0xF59563, 0xF67C5F, 0xF65E3B, 
+    0xEDCF72, 0xEDCC61, 0xEDC850, 0xEDC53F, 0xEDC22E, 0x3C3A32, 0x3C3A32, 
+    0x3C3A32, 0x3C3A32
+};
+
+static bool active;
+static uint32_t* fb;
+
+static uint8_t font[256][GLYPH_HEIGHT];
+static uint32_t sprites[15][TILE * TILE];
+
+// what's on the screen
+static uint16_t drawn_cells[TEXT_WIDTH * TEXT_HEIGHT];
+static gfx_tile_t drawn_tiles[16];
+static int drawn_count;
+
+static void (*blit)(int x, int y, const uint32_t* src, int w, int h);
+static void (*fill)(int x, int y, int w, int h, uint32_t color);
+
+static void blit_plain(int x, int y, const uint32_t* src, int w, int h)
+{
+    uint32_t* dst = fb + y * GFX_WIDTH + x;
+    for (int i = 0; i < h; i++, dst += GFX_WIDTH, src += w)
+        for (int j = 0; j < w; j++)
+            dst[j] = src[j];
+}
+
+static void fill_plain(int x, int y, int w, int h, uint32_t color)
+{
+    uint32_t* dst = fb + y * GFX_WIDTH + x;
+    for (int i = 0; i < h; i++, dst += GFX_WIDTH)
+        for (int j = 0; j < w; j++)
+            dst[j] = color;
+}
+
+// 4 pixels a store, a tile row is 24 of them
+static SSE2 void blit_sse2(int x, int y, const uint32_t* src, int w, int h)
+{
+    uint32_t* dst = fb + y * GFX_WIDTH + x;
+    for (int i = 0; i < h; i++, dst += GFX_WIDTH, src += w)
+    {
+        int j = 0;
+        for (; j + 4 <= w; j += 4)
+            *(v4u32u*) (dst + j) = *(const v4u32u*) (src + j);
+        for (; j < w; j++)
+            dst[j] = src[j];
+    }
+}
+
+static SSE2 void fill_sse2(int x, int y, int w, int h, uint32_t color)
+{
+    v4u32 v = {color, color, color, color};
+    uint32_t* dst = fb + y * GFX_WIDTH + x;
+    for (int i = 0; i < h; i++, dst += GFX_WIDTH)
+    {
+        int j = 0;
+        for (; j + 4 <= w; j += 4)
+            *(v4u32u*) (dst + j) = v;
+        for (; j < w; j++)
+            dst[j] = color;
+    }
+}
+
+static uint16_t dispi_read(uint16_t index)
+{
+    outw(_DISPI_INDEX_REGISTER, index);
+    return inw(_DISPI_DATA_REGISTER);
+}
+
+static void dispi_write(uint16_t index, uint16_t value)
+{
+    outw(_DISPI_INDEX_REGISTER, index);
+    outw(_DISPI_DATA_REGISTER, value);
+}
+
+static uint32_t pci_read(int bus, int device, int function, int reg)
+{
+    outl(_PCI_CONFIG_ADDRESS, _PCI_CONFIG_ENABLE | (bus << 16) | 
+                                    (device << 11) | (function << 8) | reg);
+    return inl(_PCI_CONFIG_DATA);
+}
+
+// BAR 0 of the Bochs/QEMU VGA (1234:1111) or VirtualBox's (80EE:BEEF), they
+// are always on bus 0
+static uint32_t lfb_address()
+{
+    for (int device = 0; device < 32; device++)
+    {
+        uint32_t id = pci_read(0, device, 0, 0x00);
+        if (id == 0x11111234 || id == 0xBEEF80EE)
+            return pci_read(0, device, 0, 0x10) & 0xFFFFFFF0;
+    }
+    return LFB_DEFAULT;
+}
+
+// The number in the middle, 3 times the font size while it fits
+static void render_sprite(int tile)
+{
+    uint32_t* sprite = sprites[tile - 1];
+    uint32_t color = tile_colors[tile];
+    uint32_t ink = tile <= 2 ? 0x776E65 : 0xF9F6F2;
+    for (int i = 0; i < TILE * TILE; i++)
+        sprite[i] = color;
+    
+    char digits[8];
+    int len = 0;
+    for (uint32_t n = 1 << tile; n != 0; n /= 10)
+        len++;
+    uint32_t n = 1 << tile;
+    for (int i = len - 1; i >= 0; i--, n /= 10)
+        digits[i] = '0' + n % 10;
+    
+    int scale = len <= 3 ? 3 : 2;
+    int x0 = (TILE - len * GLYPH_WIDTH * scale) / 2;
+    int y0 = (TILE - GLYPH_HEIGHT * scale) / 2;
+    for (int i = 0; i < len; i++)
+        for (int row = 0; row < GLYPH_HEIGHT * scale; row++)
+            for (int col = 0; col < GLYPH_WIDTH * scale; col++)
+                if (font[(uint8_t) digits[i]][row / scale] & 
+                                                (0x80 >> (col / scale)))
+                    sprite[(y0 + row) * TILE + x0 + 
+                                i * GLYPH_WIDTH * scale + col] = ink;
+}
+
+bool gfx_init()
+{
+    uint16_t id = dispi_read(_DISPI_INDEX_ID);
+    if (id < _DISPI_ID_32BPP || id > _DISPI_ID_MAX)
+        return false;
+    
+    vga_read_font(&font[0][0], GLYPH_HEIGHT);
+    
+    dispi_write(_DISPI_INDEX_ENABLE, 0);
+    dispi_write(_DISPI_INDEX_XRES, GFX_WIDTH);
+    dispi_write(_DISPI_INDEX_YRES, GFX_HEIGHT);
+    dispi_write(_DISPI_INDEX_BPP, 32);
+    dispi_write(_DISPI_INDEX_ENABLE, _DISPI_ENABLED | _DISPI_LFB_ENABLED);
+    if (dispi_read(_DISPI_INDEX_XRES) != GFX_WIDTH || 
+                dispi_read(_DISPI_INDEX_YRES) != GFX_HEIGHT || 
+                                        dispi_read(_DISPI_INDEX_BPP) != 32)
+    {
+        dispi_write(_DISPI_INDEX_ENABLE, 0);
+        return false;
+    }
+    
+    fb = (uint32_t*) lfb_address();
+    if (cpu_has(CPU_SSE2))
+    {
+        blit = blit_sse2;
+        fill = fill_sse2;
+    }
+    else
+    {
+        blit = blit_plain;
+        fill = fill_plain;
+    }
+    
+    for (int tile = 1; tile <= 15; tile++)
+        render_sprite(tile);
+    
+    // enabling clears the screen, and black on black is what 0 draws as
+    memset(drawn_cells, 0, sizeof(drawn_cells));
+    fill(BOARD_X, BOARD_Y, BOARD_SIZE, BOARD_SIZE, BOARD_COLOR);
+    drawn_count = 0;
+    active = true;
+    return true;
+}
+
+bool gfx_active()
+{
+    return active;
+}
+
+static void draw_char(int x, int y, uint16_t cell)
+{
+    uint32_t fg = palette[(cell >> 8) & 0xF];
+    uint32_t bg = palette[(cell >> 12) & 0xF];
+    uint32_t glyph[GLYPH_WIDTH * GLYPH_HEIGHT];
+    const uint8_t* bits = font[cell & 0xFF];
+    for (int row = 0; row < GLYPH_HEIGHT; row++)
+        for (int col = 0; col < GLYPH_WIDTH; col++)
+            glyph[row * GLYPH_WIDTH + col] = 
+                                    (bits[row] & (0x80 >> col)) ? fg : bg;
+    blit(x, y, glyph, GLYPH_WIDTH, GLYPH_HEIGHT);
+}
+
+static bool same_tile(const gfx_tile_t* a, const gfx_tile_t* b)
+{
+    return a->row == b->row && a->col == b->col && a->tile == b->tile;
+}
+
+// both are tiles, so it's just whether they're closer than a tile
+static bool overlap(const gfx_tile_t* a, const gfx_tile_t* b)
+{
+    int dx = TILE_X(a->col) - TILE_X(b->col);
+    int dy = TILE_Y(a->row) - TILE_Y(b->row);
+    return dx > -TILE && dx < TILE && dy > -TILE && dy < TILE;
+}
+
+void gfx_present(const uint16_t* cells, const gfx_tile_t* tiles, int count)
+{
+    if (!active)
+        return;
+    
+    for (int row = 0; row < TEXT_HEIGHT; row++)
+    {
+        for (int col = 0; col < TEXT_WIDTH; col++)
+        {
+            int i = row * TEXT_WIDTH + col;
+            if (cells[i] == drawn_cells[i] || 
+                                    (row < FIELD_ROWS && col < FIELD_COLS))
+                continue;
+            if (row < FIELD_ROWS)
+                draw_char(TEXT_RIGHT_X + (col - FIELD_COLS) * GLYPH_WIDTH, 
+                          BOARD_Y + row * GLYPH_HEIGHT, cells[i]);
+            else
+                draw_char(BOARD_X + col * GLYPH_WIDTH, 
+                          TEXT_BELOW_Y + (row - FIELD_ROWS) * GLYPH_HEIGHT, 
+                          cells[i]);
+            drawn_cells[i] = cells[i];
+        }
+    }
+    
+    // Tiles that are exactly where they were stay, the rest of the old ones
+    // get the board put back and the new ones are drawn. Ones that stay but
+    // had something cleared over them are drawn again too.
+    bool kept_old[16] = {false};
+    bool kept_new[16] = {false};
+    for (int i = 0; i < count; i++)
+    {
+        for (int j = 0; j < drawn_count; j++)
+        {
+            if (!kept_old[j] && same_tile(&tiles[i], &drawn_tiles[j]))
+            {
+                kept_old[j] = kept_new[i] = true;
+                break;
+            }
+        }
+    }
+    
+    for (int j = 0; j < drawn_count; j++)
+        if (!kept_old[j])
+            fill(TILE_X(drawn_tiles[j].col), TILE_Y(drawn_tiles[j].row), 
+                                                    TILE, TILE, BOARD_COLOR);
+    
+    for (int i = 0; i < count; i++)
+    {
+        bool draw = !kept_new[i];
+        for (int j = 0; j < drawn_count && !draw; j++)
+            draw = !kept_old[j] && overlap(&tiles[i], &drawn_tiles[j]);
+        if (draw && tiles[i].tile >= 1 && tiles[i].tile <= 15)
+            blit(TILE_X(tiles[i].col), TILE_Y(tiles[i].row), 
+                                        sprites[tiles[i].tile - 1], TILE, TILE);
+    }
+    
+    drawn_count = count < 16 ? count : 16;
+    memcpy(drawn_tiles, tiles, drawn_count * sizeof(gfx_tile_t));
+}
@@ -0,0 +1,253 @@
+//
+// history.c - undo and redo
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "game.h"
+#include "history.h"
+#include "replay.h"
+#include "rng.h"
+
+void history_init(history_t* history, history_entry_t* entries, 
+                  uint32_t size, replay_writer_t* writer, 
+                  history_store_f store, void* ctx)
+{
+    history->entries = entries;
+    history->mask = size - 1;
+    history->first = 0;
+    history->current = 0;
+    history->end = 0;
+    history->tail.board = 0;
+    history->tail.score = 0;
+    history->tail.open = false;
+    history->writer = writer;
+    history->store = store;
+    history->ctx = ctx;
+    history->written = 0;
+    history->live_valid = false;
+}
+
+// the writers only know about a ctx, these put the offsets on it
+static void store_written(void* ctx, const void* data, size_t size)
+{
+    history_t* history = ctx;
+    history->store(history->ctx, history->written, data, size);
+    history->written += size;
+}
+
+static void store_live(void* ctx, const void* data, size_t size)
+{
+    history_t* history = ctx;
+    history->store(history->ctx, history->live_written, data, size);
+    history->live_written += size;
+}
+
+// Gives entry to the replay writer and moves tail past it. Moves from
+// before the first new game have no replay to go to.
+static void feed(history_tail_t* tail, const history_entry_t* entry, 
+                 replay_writer_t* writer, replay_write_f write, void* ctx)
+{
+    game_t game;
+    game.board = entry->board;
+    game.score = tail->score + entry->score;
+    game.rng = tail->rng;
+    rng_advance(&game.rng, entry->draws);
+    
+    if (entry->dir == HISTORY_START)
+    {
+        if (tail->open)
+        {
+            game_t old;
+            old.board = tail->board;
+            old.score = tail->score;
+            old.rng = tail->rng;
+            replay_finish(writer, &old);
+        }
+        replay_begin(writer, write, ctx, &tail->rng);
+        tail->open = true;
+    }
+    else if (tail->open)
+        replay_record(writer, tail->board, entry->dir, &game);
+    
+    tail->board = game.board;
+    tail->score = game.score;
+    tail->rng = game.rng;
+}
+
+void history_push(history_t* history, int dir, const rng_t* rng, 
+                  uint64_t score, const game_t* game)
+{
+    // the first entry ever has nothing before it to come from
+    if (history->first == history->end)
+    {
+        history->tail.score = score;
+        history->tail.rng = *rng;
+    }
+    
+    // anything that could have been redone is overwritten
+    uint32_t index = history->first == history->end ? history->end : 
+                                                        history->current + 1;
+    if (index - history->first > history->mask)
+    {
+        const history_entry_t* oldest = 
+                            &history->entries[history->first & history->mask];
+        if (history->writer != 0)
+            feed(&history->tail, oldest, history->writer, store_written, 
+                                                                    history);
+        history->first++;
+    }
+    if (index < history->live_end)
+        history->live_valid = false;
+    
+    // it's almost always 1 or 2 values, just count them
+    rng_t counter = *rng;
+    uint32_t draws = 0;
+    while (counter.state != game->rng.state && draws < UINT16_MAX)
+    {
+        rng_next(&counter);
+        draws++;
+    }
+    
+    history_entry_t* entry = &history->entries[index & history->mask];
+    entry->board = game->board;
+    entry->score = (int32_t) (game->score - score);
+    entry->draws = draws;
+    entry->dir = dir;
+    entry->reserved = 0;
+    history->current = index;
+    history->end = index + 1;
+}
+
+static void restore(game_t* game, board_t board, int32_t score, 
+                                                            int64_t draws)
+{
+    game->board = board;
+    game->score += score;
+    rng_advance(&game->rng, draws);
+    game->won = board_max_tile(board) >= GAME_WIN_TILE;
+    game->lost = !board_can_move(board);
+}
+
+bool history_undo(history_t* history, game_t* game)
+{
+    if (history->current == history->first)
+        return false;
+    const history_entry_t* entry = 
+                            &history->entries[history->current & history->mask];
+    const history_entry_t* before = 
+                    &history->entries[(history->current - 1) & history->mask];
+    restore(game, before->board, -entry->score, -(int64_t) entry->draws);
+    history->current--;
+    return true;
+}
+
+bool history_redo(history_t* history, game_t* game)
+{
+    if (history->current + 1 >= history->end)
+        return false;
+    history->current++;
+    const history_entry_t* entry = 
+                            &history->entries[history->current & history->mask];
+    restore(game, entry->board, entry->score, entry->draws);
+    return true;
+}
+
+const history_entry_t* history_get(const history_t* history, uint32_t back)
+{
+    if (history->first == history->end || 
+                                back > history->current - history->first)
+        return 0;
+    return &history->entries[(history->current - back) & history->mask];
+}
+
+static void finish(history_tail_t* tail, replay_writer_t* writer)
+{
+    game_t game;
+    game.board = tail->board;
+    game.score = tail->score;
+    game.rng = tail->rng;
+    replay_finish(writer, &game);
+}
+
+void history_sync(history_t* history)
+{
+    if (history->writer == 0 || history->first == history->end)
+        return;
+    
+    // what it has was undone or replaced, or it's so far behind that the
+    // entries it needs are gone: start over from where the writer is
+    if (!history->live_valid || history->live_end > history->current + 1 || 
+                                        history->live_end < history->first)
+    {
+        history->live = *history->writer;
+        history->live.write = store_live;
+        history->live.ctx = history;
+        history->live_tail = history->tail;
+        history->live_end = history->first;
+        history->live_written = history->written;
+        history->live_valid = true;
+    }
+    for (; history->live_end != history->current + 1; history->live_end++)
+        feed(&history->live_tail, 
+                &history->entries[history->live_end & history->mask], 
+                &history->live, store_live, history);
+    
+    // on a copy, the next move goes where the end is now
+    if (history->live_tail.open)
+    {
+        replay_writer_t writer = history->live;
+        uint32_t written = history->live_written;
+        finish(&history->live_tail, &writer);
+        history->live_written = written;
+    }
+}
+
+void history_close(history_t* history)
+{
+    if (history->first == history->end)
+        return;
+    if (history->writer != 0)
+    {
+        for (; history->first != history->current + 1; history->first++)
+            feed(&history->tail, 
+                    &history->entries[history->first & history->mask], 
+                    history->writer, store_written, history);
+        if (history->tail.open)
+            finish(&history->tail, history->writer);
+        history->tail.open = false;
+    }
+    // empty, the next push starts from scratch
+    history->live_valid = false;
+    history->first = history->current + 1;
+    history->current = history->first;
+    history->end = history->first;
+}
@@ -32,8 +32,10 @@
 #include "gdt.h"
 #include "idt.h"
 #include "irq.h"
+#include "pit.h"
 #include "ports.h"
 #include "ps2.h"
+#include "serial.h"
 
 //
 // List of IRQs:
@@ -83,9 +85,15 @@ void handler(regs_t* regs)
     
     switch(irq_num)
     {
+        case 0:     // PIT
+            pit_tick();
+            break;
         case 1:     // PS/2 first
             ps2_first();
             break;
+        case 4:     // COM1
+            serial_irq();
+            break;
         case 12:    // PS/2 second
             ps2_second();
             break;
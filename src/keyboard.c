@@ -35,6 +35,9 @@
 kb_interface_t* interfaces[2];
 int interface_count = 0;
 
+pending_t sources[2];
+int source_count = 0;
+
 int buf[2];
 int buf_length;
 
@@ -144,6 +147,12 @@ void kb_add(kb_interface_t* interface)
     interface_count++;
 }
 
+void kb_add_source(pending_t pending)
+{
+    if(source_count < 2)
+        sources[source_count++] = pending;
+}
+
 bool kb_ispressed(int key)
 {
     if(pressed[key])
@@ -166,11 +175,35 @@ void kb_start()
     }
 }
 
+bool kb_available()
+{
+    for(int i = 0; i < interface_count; i++)
+        if(interfaces[i]->pending())
+            return true;
+    for(int i = 0; i < source_count; i++)
+        if(sources[i]())
+            return true;
+    return false;
+}
+
 void kb_update()
 {
+    // cli first so the interrupt can't sneak in between the check and hlt,
+    // sti only takes effect after the next instruction
+    asm volatile("cli" : :);
+    while(!kb_available())
+    {
+        asm volatile("sti\n"
+                     "hlt\n"
+                     "cli" : :);
+    }
+    asm volatile("sti" : :);
+    
     uint8_t code = 1;
     for(int i = 0; i < interface_count; i++)
     {
+            if(!interfaces[i]->pending())
+                continue;
             code = interfaces[i]->getscan();
             pressed[KEY_PAUSE] = false;
             if(interfaces[i]->mode == 1)
@@ -189,6 +222,15 @@ void kb_update()
                     case 0x13:
                         pressed[KEY_R] = value;
                         break;
+                    case 0x15:
+                        pressed[KEY_Y] = value;
+                        break;
+                    case 0x16:
+                        pressed[KEY_U] = value;
+                        break;
+                    case 0x19:
+                        pressed[KEY_P] = value;
+                        break;
                     case 0x1E:
                         pressed[KEY_LEFT] = value; // A
                         break;
@@ -198,9 +240,18 @@ void kb_update()
                     case 0x20:
                         pressed[KEY_RIGHT] = value; // D
                         break;
+                    case 0x23:
+                        pressed[KEY_H] = value;
+                        break;
+                    case 0x26:
+                        pressed[KEY_L] = value;
+                        break;
                     case 0x30:
                         pressed[KEY_B] = value;
                         break;
+                    case 0x32:
+                        pressed[KEY_M] = value;
+                        break;
                     case 0x48:
                         pressed[KEY_UP] = value; // KP8
                         break;
@@ -303,6 +354,24 @@ void kb_update()
                     case 0x32:
                         pressed[KEY_B] = value;
                         break;
+                    case 0x33:
+                        pressed[KEY_H] = value;
+                        break;
+                    case 0x35:
+                        pressed[KEY_Y] = value;
+                        break;
+                    case 0x3A:
+                        pressed[KEY_M] = value;
+                        break;
+                    case 0x3C:
+                        pressed[KEY_U] = value;
+                        break;
+                    case 0x4B:
+                        pressed[KEY_L] = value;
+                        break;
+                    case 0x4D:
+                        pressed[KEY_P] = value;
+                        break;
                     case 0x6B:
                         pressed[KEY_LEFT] = value; // KP4
                         break;
@@ -417,6 +486,24 @@ void kb_update()
                     case 0x32:
                         pressed[KEY_B] = value;
                         break;
+                    case 0x33:
+                        pressed[KEY_H] = value;
+                        break;
+                    case 0x35:
+                        pressed[KEY_Y] = value;
+                        break;
+                    case 0x3A:
+                        pressed[KEY_M] = value;
+                        break;
+                    case 0x3C:
+                        pressed[KEY_U] = value;
+                        break;
+                    case 0x4B:
+                        pressed[KEY_L] = value;
+                        break;
+                    case 0x4D:
+                        pressed[KEY_P] = value;
+                        break;
                     case 0x60:
                         pressed[KEY_DOWN] = value;
                         break;
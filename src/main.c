@@ -25,34 +25,404 @@
 * IN THE SOFTWARE.                                                             *
 *******************************************************************************/
 
+#include "anim.h"
+#include "board.h"
+#include "cpu.h"
+#include "eval.h"
+#include "game.h"
 #include "gdt.h"
+#include "history.h"
 #include "idt.h"
 #include "irq.h"
 #include "keyboard.h"
+#include "multiboot.h"
+#include "ntuple.h"
+#include "pit.h"
 #include "ps2.h"
+#include "remote.h"
+#include "replay.h"
+#include "rng.h"
+#include "rollout.h"
+#include "search.h"
+#include "serial.h"
 #include "stdio.h"
+#include "string.h"
+#include "tsc.h"
 
-static uint32_t next = 1;
+// per move time budgets, can be changed on the kernel command line with
+// autoplay_us=... and hint_us=...
+#define AUTOPLAY_BUDGET_US  1000
+#define HINT_BUDGET_US      50000
 
-uint32_t rand()
+// spawns less likely than min_prob_ppm / 1000000 aren't searched further,
+// sample_cells=N looks at only N random empty cells per spawn (0 is all)
+#define MIN_PROB_PPM        100
+#define SAMPLE_CELLS        0
+
+// how deep to search while waiting for a key, speculate_depth=0 turns it off
+#define SPECULATE_DEPTH     8
+
+// random games per first move in rollout mode (M switches to it), and how
+// many moves each one goes on for at most, rollout_depth=0 plays them out
+#define ROLLOUTS            100
+#define ROLLOUT_DEPTH       0
+
+// how often the screen gets redrawn at most, frame_hz=... on the command line,
+// everything in between just updates the game
+#define FRAME_HZ            60
+
+// COM1, baud=... on the command line. stdout=... and stderr=... pick where
+// those go, 1 is the screen, 2 is COM1 and 3 is both. The game itself is
+// only ever drawn on the screen.
+#define SERIAL_BAUD         115200
+
+// lines of the text screen, text_rows=50 is 80x50 and text_rows=60 90x60.
+// Those have room for a dashboard with what the last second took.
+#define TEXT_ROWS           25
+
+// frames a move of yours slides for, anim_frames=0 turns it off. Autoplay
+// moves never slide.
+#define ANIM_FRAMES         6
+
+#define SEARCH_TABLE_SIZE   (1 << 16)
+
+// moves that can be taken back with U, 64 KiB of them
+#define HISTORY_SIZE        4096
+
+// all the games played since boot, about 500 bytes for an average one
+#define REPLAY_SIZE         (256 * 1024)
+
+static game_t game;
+
+// counted for the dashboard, a second at a time
+static uint32_t moves_played;
+static uint32_t nodes_searched;
+static uint32_t frames_drawn;
+
+static search_entry_t search_table[SEARCH_TABLE_SIZE];
+static search_t search;
+
+// rollouts get their own stream so hints don't change where the tiles spawn
+static rng_t rollout_rng;
+static rollout_limits_t rollout_limits;
+static bool use_rollouts;
+
+static history_entry_t history_entries[HISTORY_SIZE];
+static history_t history;
+
+// The games are recorded here one after another, history_sync ends the one
+// that's going on after every move so up to replay_size they're all whole.
+// Once one doesn't fit anymore replay_full is set and nothing after the
+// last game that did is kept.
+static uint8_t replay_data[REPLAY_SIZE];
+static uint32_t replay_size;
+static bool replay_full;
+static replay_writer_t replay;
+
+// commands from bots on COM1, see remote.h
+static remote_parser_t remote;
+static bool remote_used;
+
+static ntuple_t weights;
+static bool has_weights;
+
+static void load_weights()
+{
+    const multiboot_module_t* mod = multiboot_find_module("weights");
+    if(mod == 0)
+    {
+        printf("No n-tuple weights module loaded\n");
+        return;
+    }
+    printf("Mapping n-tuple weights... ");
+    int err = ntuple_map(&weights, (const void*) mod->mod_start, 
+                                            mod->mod_end - mod->mod_start);
+    if(err != NTUPLE_OK)
+    {
+        printf("Error!\n%s\n", ntuple_strerror(err));
+        return;
+    }
+    has_weights = true;
+    printf("Done!\n%d tuples, %d weights\n", weights.count, 
+                                                    (int) weights.weight_count);
+}
+
+// Only for the seed, the game's own generator is much faster. RDSEED is
+// straight from the entropy source, RDRAND is good enough too.
+static uint64_t hardware_seed()
 {
-    next = next * 1103515245 + 12345;
-    return (uint32_t)(next / 65536) % 32768;
+    uint32_t low = 420;
+    uint32_t high = 0;
+    if (cpu_has(CPU_RDSEED))
+        asm volatile (
+            "1: "
+            "rdseed %%eax\n"
+            "jnc 1b\n"
+            "2: "
+            "rdseed %%edx\n"
+            "jnc 2b"
+            : "=a" (low), "=d" (high)
+        );
+    else
+        asm volatile (
+            "1: "
+            "rdrand %%eax\n"
+            "jnc 1b\n"
+            "2: "
+            "rdrand %%edx\n"
+            "jnc 2b"
+            : "=a" (low), "=d" (high)
+        );
+    return ((uint64_t) high << 32) | low;
 }
 
-void srand(uint32_t seed)
+// Plays every replay in the modules called "replay" again and prints what
+// didn't check out. Returns whether there were any.
+static bool verify_replays()
 {
-    next = seed;
+    uint32_t count = 0;
+    uint32_t bad = 0;
+    uint64_t moves = 0;
+    uint64_t start = tsc_read();
+    const multiboot_module_t* mod = 0;
+    while ((mod = multiboot_next_module("replay", mod)) != 0)
+    {
+        const uint8_t* data = (const uint8_t*) mod->mod_start;
+        size_t size = mod->mod_end - mod->mod_start;
+        size_t offset = 0;
+        while (offset < size)
+        {
+            replay_check_t check;
+            replay_verify(data + offset, size - offset, &check);
+            count++;
+            moves += check.moves;
+            size_t length = check.size;
+            if (check.err != REPLAY_OK)
+            {
+                if (++bad <= 10)
+                    printf("Replay %u: move %u: %s\n", count, check.moves + 1, 
+                                                replay_strerror(check.err));
+                // the next one can still be found if this one is whole
+                length = replay_length(data + offset, size - offset);
+                if (length == 0)
+                    break;
+            }
+            offset += length;
+        }
+    }
+    if (count == 0)
+        return false;
+    
+    uint32_t us = tsc_to_us(tsc_read() - start);
+    printf("Checked %u replays (%M moves) in %u us, %u bad\n", count, moves, 
+                                                                    us, bad);
+    return true;
 }
 
-void main()
+static void replay_store(void* ctx, uint32_t offset, const void* data, 
+                         size_t size)
+{
+    (void) ctx;
+    if (replay_full)
+        return;
+    // the writes never leave a gap, so offset is never past the end
+    if (size > REPLAY_SIZE - offset)
+    {
+        // everything before offset is what was written, whatever game
+        // doesn't end in there is cut off
+        replay_full = true;
+        replay_size = 0;
+        size_t length;
+        while ((length = replay_length(replay_data + replay_size, 
+                                            offset - replay_size)) != 0)
+            replay_size += length;
+        return;
+    }
+    memcpy(replay_data + offset, data, size);
+    replay_size = offset + size;
+}
+
+static void new_game(game_t* game)
+{
+    rng_t rng = game->rng;
+    uint64_t score = game->score;
+    game_reset(game);
+    history_push(&history, HISTORY_START, &rng, score, game);
+    history_sync(&history);
+}
+
+// Makes the move, with the successor from the speculative search if there is
+// one for the current board so it doesn't have to be computed again
+static bool play(game_t* game, int dir, const search_result_t* spec)
+{
+    rng_t rng = game->rng;
+    uint64_t score = game->score;
+    bool moved;
+    if (spec == 0)
+        moved = game_move(game, dir);
+    else
+        moved = game_play(game, spec->after[dir], spec->reward[dir]);
+    if (moved)
+    {
+        moves_played++;
+        history_push(&history, dir, &rng, score, game);
+        history_sync(&history);
+    }
+    return moved;
+}
+
+static void remote_reply(uint8_t command, const void* payload, size_t length)
+{
+    uint8_t frame[REMOTE_MAX_FRAME];
+    serial_write(frame, remote_encode(command, payload, length, frame));
+}
+
+// A piece of the replays from the offset in the command
+static void send_replay(const remote_frame_t* frame)
+{
+    uint8_t payload[REMOTE_MAX_PAYLOAD];
+    remote_replay_t header;
+    memcpy(&header.offset, frame->payload, sizeof(header.offset));
+    header.size = replay_size;
+    header.flags = replay_full ? REMOTE_FULL : 0;
+    uint32_t length = 0;
+    if (header.offset < replay_size)
+    {
+        length = replay_size - header.offset;
+        if (length > REMOTE_MAX_REPLAY)
+            length = REMOTE_MAX_REPLAY;
+        memcpy(payload + sizeof(header), replay_data + header.offset, length);
+    }
+    memcpy(payload, &header, sizeof(header));
+    remote_reply(REMOTE_REPLY_REPLAY, payload, sizeof(header) + length);
+}
+
+// Plays whatever came in over COM1 and answers every command with the state
+// after it, or the replays it asked for. Returns whether the game changed.
+static bool serve_remote()
+{
+    bool changed = false;
+    uint8_t byte;
+    while (serial_read(&byte))
+    {
+        int status = remote_feed(&remote, byte);
+        if (status == REMOTE_NONE)
+            continue;
+        if (status != REMOTE_FRAME)
+        {
+            int8_t err = status;
+            remote_reply(REMOTE_REPLY_ERROR, &err, 1);
+            continue;
+        }
+        // from now on COM1 is only for frames
+        if (!remote_used)
+        {
+            remote_used = true;
+            stdout->targets &= ~_STREAM_SERIAL;
+            stderr->targets &= ~_STREAM_SERIAL;
+        }
+        
+        const remote_frame_t* frame = &remote.frame;
+        if (frame->command == REMOTE_CMD_REPLAY)
+        {
+            send_replay(frame);
+            continue;
+        }
+        int applied = 0;
+        if (frame->command == REMOTE_CMD_MOVE)
+            applied = play(&game, frame->payload[0], 0);
+        else if (frame->command == REMOTE_CMD_RESET)
+        {
+            if (frame->length == sizeof(uint64_t))
+            {
+                uint64_t seed;
+                memcpy(&seed, frame->payload, sizeof(seed));
+                history_close(&history);
+                rng_seed(&game.rng, seed);
+            }
+            new_game(&game);
+            changed = true;
+        }
+        else if (frame->command == REMOTE_CMD_BATCH)
+        {
+            int count = remote_batch_count(frame);
+            for (int i = 0; i < count && !game.lost; i++)
+                applied += play(&game, remote_batch_dir(frame, i), 0);
+        }
+        changed |= applied > 0;
+        
+        remote_state_t state;
+        remote_state(&game, applied, &state);
+        state.flags |= replay_full ? REMOTE_FULL : 0;
+        remote_reply(REMOTE_REPLY_STATE, &state, sizeof(state));
+    }
+    return changed;
+}
+
+// Asks whichever AI is picked for a move. Rollouts fill in the same result as
+// the search, depth is the average length of a rollout and nodes the moves in
+// all of them.
+static void think(board_t board, const search_limits_t* limits, 
+                  search_result_t* ai)
+{
+    if (!use_rollouts)
+    {
+        search_run(&search, board, limits, ai);
+        nodes_searched += ai->nodes;
+        return;
+    }
+    rollout_result_t result;
+    rollout_run(board, &rollout_limits, &rollout_rng, &result);
+    ai->dir = result.dir;
+    ai->value = result.value;
+    ai->depth = result.rollouts != 0 ? result.steps / result.rollouts : 0;
+    ai->nodes = result.steps;
+    ai->cutoffs = 0;
+    ai->us = result.us;
+    nodes_searched += ai->nodes;
+}
+
+void main(uint32_t magic, multiboot_info_t* mbi)
 {
     _text_init();
     printf("Welcome to 2048/Arkta! :D\n");
     printf("Loading, please wait...\n");
+    cpu_init();
+    _string_init();
+    printf("CPU: %s", cpu_vendor());
+    for (int i = 0; i < CPU_FEATURE_COUNT; i++)
+        if (cpu_has(1 << i))
+            printf(" %s", cpu_feature_name(i));
+    printf("\n");
+    multiboot_init(magic, mbi);
+    stdout->targets = multiboot_cmdline_uint("stdout", stdout->targets);
+    stderr->targets = multiboot_cmdline_uint("stderr", stderr->targets);
+    // the graphics are 80x25 only
+    uint32_t text_rows = multiboot_cmdline_uint("text_rows", TEXT_ROWS);
+    bool dashboard = false;
+    if (text_rows != TEXT_ROWS && !multiboot_cmdline_has("gfx"))
+    {
+        dashboard = _text_mode(text_rows);
+        if (dashboard)
+            printf("Loading in %u line text mode, please wait...\n", 
+                                                                    text_rows);
+        else
+            printf("No %u line text mode, staying at %u\n", text_rows, 
+                                                                TEXT_ROWS);
+    }
+    load_weights();
     gdt_init();
     idt_init();
     irq_init();
+    uint32_t baud = multiboot_cmdline_uint("baud", SERIAL_BAUD);
+    if (serial_init(baud))
+    {
+        printf("Serial console on COM1 at %u baud\n", baud);
+        remote_parser_init(&remote);
+        kb_add_source(serial_pending);
+    }
+    else
+        printf("No serial port\n");
     ps2_init();
     if (!ps2_status())
     {
@@ -61,83 +431,205 @@ void main()
         for(;;);
     }
     printf("Generating a random number...\n");
-    // check if we have hardware random available
-    
-    int available = 2;
-    
-    asm volatile (
-        "movl $1, %%eax\n"
-        "movl $0, %%ecx\n"
-        "cpuid\n"
-        "shr $30, %%ecx\n"
-        "and $1, %%ecx\n"
-        : "=c" (available)
-        :
-        : "eax"
-    );
-    
-    if (available != 1)
-    {
+    uint64_t seed = 420;
+    if (!cpu_has(CPU_RDRAND))
         printf("Hardware generated random numbers not available :(\n");
-        srand(420);
-        rand();
-        rand();
-    }
     else
     {
         printf("Hardware generated random number is available, generating\n");
-        int seed = 420;
-        asm volatile (
-            "begin: "
-            "rdrand %%eax\n"
-            "jnc begin"
-            : "=a" (seed)
-        );
-        srand(seed);
-        rand();
-        rand();
+        seed = hardware_seed();
     }
-    asm("sti");
+    rng_seed(&game.rng, seed);
+    rng_seed_stream(&rollout_rng, seed, 1);
+    printf("Building move tables... ");
+    board_init();
+    printf("moving with %s\n", board_kernel_name(board_kernel()));
+    eval_init();
+    if (has_weights)
+        eval_set_network(&weights);
+    printf("Measuring the TSC... ");
+    tsc_init();
+    printf("%u MHz\n", tsc_per_us());
+    printf("Measuring the refresh rate... ");
+    printf("%u Hz\n", _text_refresh_init());
+    search_init(&search, search_table, SEARCH_TABLE_SIZE);
     
-    int data[4][4]; // we store the exponent not the product here
-                    // so 1, 2, 3, 4 not 2, 4, 8, 16
+    search_limits_t autoplay_limits;
+    autoplay_limits.budget_us = multiboot_cmdline_uint("autoplay_us", 
+                                                        AUTOPLAY_BUDGET_US);
+    autoplay_limits.max_depth = SEARCH_MAX_DEPTH;
+    autoplay_limits.min_prob = multiboot_cmdline_uint("min_prob_ppm", 
+                                                    MIN_PROB_PPM) / 1000000.0f;
+    autoplay_limits.sample_cells = multiboot_cmdline_uint("sample_cells", 
+                                                                SAMPLE_CELLS);
+    autoplay_limits.abort = 0;
+    search_limits_t hint_limits = autoplay_limits;
+    hint_limits.budget_us = multiboot_cmdline_uint("hint_us", HINT_BUDGET_US);
+    // no time limit, it stops as soon as a key comes in
+    search_limits_t spec_limits = autoplay_limits;
+    spec_limits.budget_us = 0;
+    spec_limits.max_depth = multiboot_cmdline_uint("speculate_depth", 
+                                                            SPECULATE_DEPTH);
+    spec_limits.abort = kb_available;
+    rollout_limits.rollouts = multiboot_cmdline_uint("rollouts", ROLLOUTS);
+    rollout_limits.depth = multiboot_cmdline_uint("rollout_depth", 
+                                                                ROLLOUT_DEPTH);
     
-    // initialize the data
+    history_init(&history, history_entries, HISTORY_SIZE, &replay, 
+                                                            replay_store, 0);
     
-    for (int x = 0; x < 4; x++)
-        for (int y = 0; y < 4; y++)
-            data[x][y] = 0;
+    uint32_t frame_hz = multiboot_cmdline_uint("frame_hz", FRAME_HZ);
+    uint32_t anim_frames = multiboot_cmdline_uint("anim_frames", ANIM_FRAMES);
+    if (frame_hz == 0)
+        frame_hz = FRAME_HZ;
+    pit_init(frame_hz);
     
-    int a = rand() % 4;
-    int b = rand() % 4;
-    int c = rand() % 4;
-    int d = rand() % 4;
-    while (a == c && b == d)
+    asm("sti");
+    
+    if (verify_replays())
+    {
+        printf("Press any key to play\n");
+        kb_update();
+    }
+    
+    // with "gfx" on the command line the game is drawn in 1024x768 instead
+    if (multiboot_cmdline_has("gfx") && !_text_graphics())
     {
-        c = rand() % 4;
-        d = rand() % 4;
+        printf("No Bochs VBE adapter for graphics, staying in text mode\n");
+        printf("Press any key to play\n");
+        kb_update();
     }
-    data[a][b] = 1;
-    data[c][d] = 1;
+    
+    new_game(&game);
     
     bool changed = true;
-    bool lost = false;
-    bool won = false;
+    bool autoplay = false;
+    bool show_ai = false;
+    // with L the AI line is about the last move instead of the board, this
+    // is the move that was made, -1 for a hint or autoplay
+    int what_if = -1;
+    static const char* instead_of[DIR_COUNT] = {
+        "Instead of Up", "Instead of Down", "Instead of Left", 
+        "Instead of Right"
+    };
+    search_result_t ai;
+    
+    // what was searched while waiting for a key, only valid for spec_board
+    search_result_t spec;
+    board_t spec_board = 0;
+    bool spec_valid = false;
+    bool spec_done = false;
     
-    uint64_t score = 0;
     uint64_t highscore = 0;
     
+    anim_t anim;
+    anim.running = false;
+    
+    // the tick of the last frame drawn, one behind so the first one goes now
+    uint32_t frame = pit_ticks() - 1;
+    
+    // what the dashboard shows, from the time before dash_tick
+    uint32_t dash_tick = pit_ticks();
+    uint32_t dash_fps = 0;
+    uint32_t dash_moves = 0;
+    uint32_t dash_nodes = 0;
+    uint32_t dash_cells = 0;
+    
     for (;;)
     {
-        if (changed)
+        // waiting for a key can take longer than a second, it's per second
+        uint32_t elapsed = pit_ticks() - dash_tick;
+        if (elapsed >= frame_hz)
+        {
+            dash_fps = (uint64_t) frames_drawn * frame_hz / elapsed;
+            dash_moves = (uint64_t) moves_played * frame_hz / elapsed;
+            dash_nodes = (uint64_t) nodes_searched * frame_hz / elapsed;
+            dash_cells = _text_copied() / (frames_drawn ? frames_drawn : 1);
+            frames_drawn = 0;
+            moves_played = 0;
+            nodes_searched = 0;
+            dash_tick = pit_ticks();
+            // only the dashboard is different, that's all that gets drawn
+            changed |= dashboard;
+        }
+        
+        // keys and the AI change the game as fast as they come, the screen
+        // only gets the latest state once a tick. The AI doesn't wait for a 
+        // flip either, it plays on and the next tick shows where it got to
+        bool thinking = autoplay && !game.lost && !kb_available();
+        if (changed && pit_ticks() != frame && (!thinking || _text_ready()))
         {
-            _text_drawfield(data, lost, won, score, highscore);
+            // the board comes after the last frame of a slide
+            if (anim_draw(&anim, pit_ticks()))
+            {
+                frames_drawn++;
+                frame = pit_ticks();
+                continue;
+            }
+            _text_drawfield(game.board, game.lost, game.won, game.score, 
+                                                                    highscore);
+            if (show_ai)
+                _text_drawai(what_if >= 0 ? instead_of[what_if] : 
+                             use_rollouts ? "Rollouts" : "AI", ai.dir, 
+                             ai.depth, ai.nodes, ai.us, autoplay);
+            _text_drawdash(dash_fps, dash_moves, dash_nodes, dash_cells);
+            _text_present();
+            frames_drawn++;
+            frame = pit_ticks();
             changed = false;
         }
         
-        bool spawn = false;
+        if (thinking)
+        {
+            think(game.board, &autoplay_limits, &ai);
+            if (ai.dir >= 0)
+                play(&game, ai.dir, 0);
+            show_ai = true;
+            what_if = -1;
+            changed = true;
+            if (game.score > highscore)
+                highscore = game.score;
+            continue;
+        }
+        
+        // a frame is owed but it's not time yet, sleep until it is unless a 
+        // key gets here first
+        if (changed && !kb_available())
+        {
+            asm volatile("cli" : :);
+            while (pit_ticks() == frame && !kb_available())
+                asm volatile("sti\n"
+                             "hlt\n"
+                             "cli" : :);
+            asm volatile("sti" : :);
+            continue;
+        }
+        
+        // nothing to do until the next key, think ahead in the meantime
+        if (spec_limits.max_depth > 0 && !autoplay && !game.lost && 
+                                                            !kb_available() && 
+                                    (!spec_valid || spec_board != game.board || 
+                                                                    !spec_done))
+        {
+            search_run(&search, game.board, &spec_limits, &spec);
+            spec_board = game.board;
+            spec_valid = true;
+            spec_done = !search.aborted;
+            // if it was cut short a key is waiting already
+        }
         
         kb_update();
+        // anything pressed ends the slide, the key doesn't wait for it
+        anim_finish(&anim);
+        if (serve_remote())
+        {
+            changed = true;
+            show_ai = false;
+        }
+        // after the bot's moves, a key in the same pass plays on from there
+        bool spec_ready = spec_valid && spec_board == game.board;
+        board_t before = game.board;
+        int dir = -1;
         if (kb_ispressed(KEY_B))
         {
             _text_switchstyle();
@@ -145,268 +637,83 @@ void main()
         }
         else if (kb_ispressed(KEY_R))
         {
-            for (int x = 0; x < 4; x++)
-                for (int y = 0; y < 4; y++)
-                    data[x][y] = 0;
-            
-            int a = rand() % 4;
-            int b = rand() % 4;
-            int c = rand() % 4;
-            int d = rand() % 4;
-            while (a == c && b == d)
-            {
-                c = rand() % 4;
-                d = rand() % 4;
-            }
-            data[a][b] = 1;
-            data[c][d] = 1;
-            lost = false;
-            won = false;
-            score = 0;
+            new_game(&game);
+            show_ai = false;
             changed = true;
         }
-        else if (kb_ispressed(KEY_RIGHT))
+        else if (kb_ispressed(KEY_H))
         {
-            for (int x = 0; x < 4; x++)
-            {
-                bool matched = false;
-                for (int y = 2; y >= 0; y--)
-                {
-                    if (data[x][y] != 0)
-                        for (int y2 = 3; y2 > y; y2--)
-                        {
-                            if (data[x][y2] == 0)
-                            {
-                                data[x][y2] = data[x][y];
-                                data[x][y] = 0;
-                                matched = false;
-                                y2 = y;
-                                spawn = true;
-                            }
-                            else if (!matched && data[x][y2] == data[x][y])
-                            {
-                                bool legit = true;
-                                for (int i = y2 - 1; i > y; i--)
-                                {
-                                    if (data[x][i] != 0)
-                                    {
-                                        legit = false;
-                                        i = y;
-                                    }
-                                }
-                                if(legit)
-                                {
-                                    data[x][y2]++;
-                                    score += 1 << data[x][y2];
-                                    if (data[x][y2] == 11)
-                                        won = true;
-                                    data[x][y] = 0;
-                                    matched = true;
-                                    y2 = y;
-                                    spawn = true;
-                                }
-                            }
-                        }
-                }
-            }
+            if (spec_ready && spec_done && !use_rollouts)
+                ai = spec;
+            else
+                think(game.board, &hint_limits, &ai);
+            show_ai = true;
+            what_if = -1;
+            changed = true;
         }
-        else if (kb_ispressed(KEY_LEFT))
+        else if (kb_ispressed(KEY_L))
         {
-            for (int x = 0; x < 4; x++)
+            // what the AI would have done where the last move was made
+            const history_entry_t* last = history_get(&history, 0);
+            const history_entry_t* before_last = history_get(&history, 1);
+            if (last != 0 && before_last != 0 && last->dir != HISTORY_START)
             {
-                bool matched = false;
-                for (int y = 1; y < 4; y++)
-                {
-                    if (data[x][y] != 0)
-                        for (int y2 = 0; y2 < y; y2++)
-                        {
-                            if (data[x][y2] == 0)
-                            {
-                                data[x][y2] = data[x][y];
-                                data[x][y] = 0;
-                                matched = false;
-                                y2 = y;
-                                spawn = true;
-                            }
-                            else if (!matched && data[x][y2] == data[x][y])
-                            {
-                                bool legit = true;
-                                for (int i = y2 + 1; i < y; i++)
-                                {
-                                    if (data[x][i] != 0)
-                                    {
-                                        legit = false;
-                                        i = y;
-                                    }
-                                }
-                                if(legit)
-                                {
-                                    data[x][y2]++;
-                                    score += 1 << data[x][y2];
-                                    if (data[x][y2] == 11)
-                                        won = true;
-                                    data[x][y] = 0;
-                                    matched = true;
-                                    y2 = y;
-                                    spawn = true;
-                                }
-                            }
-                        }
-                }
+                think(before_last->board, &hint_limits, &ai);
+                show_ai = true;
+                what_if = last->dir;
+                changed = true;
             }
         }
-        else if (kb_ispressed(KEY_DOWN))
+        else if (kb_ispressed(KEY_U))
         {
-            for (int y = 0; y < 4; y++)
-            {
-                bool matched = false;
-                for (int x = 2; x >= 0; x--)
-                {
-                    if (data[x][y] != 0)
-                        for (int x2 = 3; x2 > x; x2--)
-                        {
-                            if (data[x2][y] == 0)
-                            {
-                                data[x2][y] = data[x][y];
-                                data[x][y] = 0;
-                                matched = false;
-                                x2 = x;
-                                spawn = true;
-                            }
-                            else if (!matched && data[x2][y] == data[x][y])
-                            {
-                                bool legit = true;
-                                for (int i = x2 - 1; i > x; i--)
-                                {
-                                    if (data[i][y] != 0)
-                                    {
-                                        legit = false;
-                                        i = x;
-                                    }
-                                }
-                                if(legit)
-                                {
-                                    data[x2][y]++;
-                                    score += 1 << data[x2][y];
-                                    if (data[x2][y] == 11)
-                                        won = true;
-                                    data[x][y] = 0;
-                                    matched = true;
-                                    x2 = x;
-                                    spawn = true;
-                                }
-                            }
-                        }
-                }
-            }
+            changed |= history_undo(&history, &game);
+            history_sync(&history);
         }
-        else if (kb_ispressed(KEY_UP))
+        else if (kb_ispressed(KEY_Y))
         {
-            for (int y = 0; y < 4; y++)
-            {
-                bool matched = false;
-                for (int x = 1; x < 4; x++)
-                {
-                    if (data[x][y] != 0)
-                        for (int x2 = 0; x2 < x; x2++)
-                        {
-                            if (data[x2][y] == 0)
-                            {
-                                data[x2][y] = data[x][y];
-                                data[x][y] = 0;
-                                matched = false;
-                                x2 = x;
-                                spawn = true;
-                            }
-                            else if (!matched && data[x2][y] == data[x][y])
-                            {
-                                bool legit = true;
-                                for (int i = x2 + 1; i < x; i++)
-                                {
-                                    if (data[i][y] != 0)
-                                    {
-                                        legit = false;
-                                        i = x;
-                                    }
-                                }
-                                if(legit)
-                                {
-                                    data[x2][y]++;
-                                    score += 1 << data[x2][y];
-                                    if (data[x2][y] == 11)
-                                        won = true;
-                                    data[x][y] = 0;
-                                    matched = true;
-                                    x2 = x;
-                                    spawn = true;
-                                }
-                            }
-                        }
-                }
-            }
+            changed |= history_redo(&history, &game);
+            history_sync(&history);
         }
-        
-        if(spawn)
+        else if (kb_ispressed(KEY_M))
         {
-            int count = 0;
-            int empties[16];
-            for (int x = 0; x < 4; x++)
-            {
-                for (int y = 0; y < 4; y++)
-                {
-                    if (data[x][y] == 0)
-                    {
-                        empties[count] = x * 4 + y;
-                        count++;
-                    }
-                }
-            }
-            
-            if (count > 0)
-            {
-                int choice = empties[rand() % count];
-                if (rand() % 10)
-                    data[choice / 4][choice % 4] = 1;
-                else
-                    data[choice / 4][choice % 4] = 2;
-            }
-            
+            use_rollouts = !use_rollouts;
+            show_ai = false;
             changed = true;
         }
-        
-        bool not_lost = false;
-        for (int x = 0; x < 3; x++)
+        else if (kb_ispressed(KEY_P))
         {
-            for (int y = 0; y < 4; y++)
-            {
-                if (data[x][y] == data[x + 1][y] || data[x][y] == 0)
-                {
-                    not_lost = true;
-                    y = 4;
-                    x = 3;
-                }
-            }
+            autoplay = !autoplay;
+            changed = true;
         }
-        if(!not_lost)
+        else if (kb_ispressed(KEY_RIGHT))
+            dir = DIR_RIGHT;
+        else if (kb_ispressed(KEY_LEFT))
+            dir = DIR_LEFT;
+        else if (kb_ispressed(KEY_DOWN))
+            dir = DIR_DOWN;
+        else if (kb_ispressed(KEY_UP))
+            dir = DIR_UP;
+        
+        // a key that doesn't move anything mustn't drop a frame that's
+        // still owed from the ones before it
+        if (dir >= 0 && play(&game, dir, spec_ready ? &spec : 0))
         {
-            for (int x = 0; x < 4; x++)
+            changed = true;
+            if (anim_frames > 0)
             {
-                for (int y = 0; y < 3; y++)
-                {
-                    if (data[x][y] == data[x][y + 1] || data[x][y] == 0)
-                    {
-                        not_lost = true;
-                        y = 3;
-                        x = 4;
-                    }
-                }
+                board_trace_t trace;
+                board_trace(before, dir, &trace);
+                anim_start(&anim, &trace, pit_ticks(), anim_frames);
             }
         }
-        lost = !not_lost;
         
-        if(score > highscore)
+        // a hint is only good for the position it was asked for
+        if (game.board != before)
+            show_ai = false;
+        
+        if(game.score > highscore)
         {
-            highscore = score;
+            highscore = game.score;
         }
     }
 }
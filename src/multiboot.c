@@ -0,0 +1,122 @@
+//
+// multiboot.c - looking around in what the bootloader gave us
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "multiboot.h"
+
+static multiboot_info_t* info;
+
+void multiboot_init(uint32_t magic, multiboot_info_t* mbi)
+{
+    if(magic != MULTIBOOT_BOOTLOADER_MAGIC)
+    {
+        printf("Not booted by a multiboot bootloader, no modules\n");
+        info = 0;
+        return;
+    }
+    info = mbi;
+}
+
+// is name one of the space separated words in cmdline?
+static bool has_word(const char* cmdline, const char* name)
+{
+    while(*cmdline != 0)
+    {
+        while(*cmdline == ' ')
+            cmdline++;
+        size_t i = 0;
+        while(name[i] != 0 && cmdline[i] == name[i])
+            i++;
+        if(name[i] == 0 && (cmdline[i] == ' ' || cmdline[i] == 0))
+            return true;
+        while(*cmdline != ' ' && *cmdline != 0)
+            cmdline++;
+    }
+    return false;
+}
+
+const multiboot_module_t* multiboot_find_module(const char* name)
+{
+    return multiboot_next_module(name, 0);
+}
+
+const multiboot_module_t* multiboot_next_module(const char* name, 
+                                                const multiboot_module_t* prev)
+{
+    if(info == 0 || !(info->flags & MULTIBOOT_INFO_MODS))
+        return 0;
+    
+    const multiboot_module_t* mods = 
+                                (const multiboot_module_t*) info->mods_addr;
+    uint32_t start = prev == 0 ? 0 : prev - mods + 1;
+    for(uint32_t i = start; i < info->mods_count; i++)
+        if(mods[i].cmdline != 0 && has_word((const char*) mods[i].cmdline, 
+                                                                        name))
+            return &mods[i];
+    return 0;
+}
+
+uint32_t multiboot_cmdline_uint(const char* name, uint32_t def)
+{
+    if(info == 0 || !(info->flags & MULTIBOOT_INFO_CMDLINE) || 
+                                                            info->cmdline == 0)
+        return def;
+    
+    const char* cmdline = (const char*) info->cmdline;
+    while(*cmdline != 0)
+    {
+        while(*cmdline == ' ')
+            cmdline++;
+        size_t i = 0;
+        while(name[i] != 0 && cmdline[i] == name[i])
+            i++;
+        if(name[i] == 0 && cmdline[i] == '=' && 
+                                    cmdline[i + 1] >= '0' && cmdline[i + 1] <= '9')
+        {
+            uint32_t value = 0;
+            for(cmdline += i + 1; *cmdline >= '0' && *cmdline <= '9'; cmdline++)
+                value = value * 10 + (*cmdline - '0');
+            return value;
+        }
+        while(*cmdline != ' ' && *cmdline != 0)
+            cmdline++;
+    }
+    return def;
+}
+
+bool multiboot_cmdline_has(const char* word)
+{
+    if(info == 0 || !(info->flags & MULTIBOOT_INFO_CMDLINE) || 
+                                                            info->cmdline == 0)
+        return false;
+    return has_word((const char*) info->cmdline, word);
+}
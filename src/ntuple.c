@@ -0,0 +1,184 @@
+//
+// ntuple.c - n-tuple network value function
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "cpu.h"
+#include "ntuple.h"
+
+int ntuple_map(ntuple_t* net, const void* buf, size_t size)
+{
+    const uint8_t* file = (const uint8_t*) buf;
+    const ntuple_header_t* header = (const ntuple_header_t*) file;
+    
+    if(size < sizeof(ntuple_header_t))
+        return NTUPLE_ERR_SIZE;
+    if(header->magic != NTUPLE_MAGIC)
+        return NTUPLE_ERR_MAGIC;
+    if(header->version > NTUPLE_VERSION)
+        return NTUPLE_ERR_VERSION;
+    if(header->count == 0 || header->count > NTUPLE_MAX_TUPLES)
+        return NTUPLE_ERR_TUPLE;
+    
+    size_t tuples_end = sizeof(ntuple_header_t) + 
+                                    header->count * sizeof(ntuple_tuple_t);
+    if(size < tuples_end)
+        return NTUPLE_ERR_SIZE;
+    if(header->weights_offset < tuples_end || 
+                                    header->weights_offset % NTUPLE_ALIGN != 0 ||
+                                    ((uintptr_t) file) % 2 != 0)
+        return NTUPLE_ERR_ALIGN;
+    
+    const ntuple_tuple_t* tuples = 
+                    (const ntuple_tuple_t*) (file + sizeof(ntuple_header_t));
+    size_t offset = header->weights_offset;
+    net->ascending = true;
+    for(int i = 0; i < header->count; i++)
+    {
+        if(tuples[i].length == 0 || tuples[i].length > NTUPLE_MAX_LENGTH)
+            return NTUPLE_ERR_TUPLE;
+        uint16_t seen = 0;
+        net->masks[i] = 0;
+        for(int j = 0; j < tuples[i].length; j++)
+        {
+            if(tuples[i].cells[j] >= 16 || (seen & (1 << tuples[i].cells[j])))
+                return NTUPLE_ERR_TUPLE;
+            seen |= 1 << tuples[i].cells[j];
+            if(j > 0 && tuples[i].cells[j] < tuples[i].cells[j - 1])
+                net->ascending = false;
+            net->masks[i] |= (board_t) 0xF << (tuples[i].cells[j] * 4);
+        }
+        net->high_shift[i] = 4 * board_popcount16(seen & 0xFF);
+        
+        size_t table = ntuple_table_size(tuples[i].length) * sizeof(int16_t);
+        if(size < offset || size - offset < table)
+            return NTUPLE_ERR_SIZE;
+        net->tables[i] = (const int16_t*) (file + offset);
+        offset += table;
+    }
+    
+    net->count = header->count;
+    net->frac_bits = header->frac_bits;
+    net->weight_count = (offset - header->weights_offset) / sizeof(int16_t);
+    net->tuples = tuples;
+    return NTUPLE_OK;
+}
+
+const char* ntuple_strerror(int err)
+{
+    switch(err)
+    {
+        case NTUPLE_OK:
+            return "OK";
+        case NTUPLE_ERR_SIZE:
+            return "file is truncated";
+        case NTUPLE_ERR_MAGIC:
+            return "not a weight file";
+        case NTUPLE_ERR_VERSION:
+            return "unsupported version";
+        case NTUPLE_ERR_TUPLE:
+            return "bad tuple";
+        case NTUPLE_ERR_ALIGN:
+            return "misaligned weights";
+        default:
+            return "unknown error";
+    }
+}
+
+void ntuple_symmetries(board_t board, board_t sym[8])
+{
+    board_t t = board_transpose(board);
+    sym[0] = board;
+    sym[1] = board_mirror(board);
+    sym[2] = board_flip(board);
+    sym[3] = board_flip(sym[1]);    // rotated 180 degrees
+    sym[4] = t;
+    sym[5] = board_mirror(t);       // rotated one way
+    sym[6] = board_flip(t);         // rotated the other way
+    sym[7] = board_flip(sym[5]);    // transposed along the other diagonal
+}
+
+static int32_t eval_generic(const ntuple_t* net, board_t board)
+{
+    board_t sym[8];
+    ntuple_symmetries(board, sym);
+    
+    // tuple by tuple so every table gets its 8 lookups back to back
+    int32_t sum = 0;
+    for(int i = 0; i < net->count; i++)
+    {
+        const int16_t* table = net->tables[i];
+        const ntuple_tuple_t* tuple = &net->tuples[i];
+        for(int s = 0; s < 8; s++)
+            sum += table[ntuple_index(tuple, sym[s])];
+    }
+    return sum;
+}
+
+// With the cells of a tuple going up, its index is just those nibbles packed
+// together, which is what pext does. 32-bit only has the 32-bit one.
+__attribute__((target("bmi2")))
+static inline uint32_t pext_index(const ntuple_t* net, int i, board_t board)
+{
+#ifdef __x86_64__
+    return __builtin_ia32_pext_di(board, net->masks[i]);
+#else
+    return __builtin_ia32_pext_si((uint32_t) board, (uint32_t) net->masks[i]) | 
+            (__builtin_ia32_pext_si((uint32_t) (board >> 32), 
+                        (uint32_t) (net->masks[i] >> 32)) << net->high_shift[i]);
+#endif
+}
+
+__attribute__((target("bmi2")))
+static int32_t eval_bmi2(const ntuple_t* net, board_t board)
+{
+    if(!net->ascending)
+        return eval_generic(net, board);
+    
+    board_t sym[8];
+    ntuple_symmetries(board, sym);
+    
+    int32_t sum = 0;
+    for(int i = 0; i < net->count; i++)
+    {
+        const int16_t* table = net->tables[i];
+        for(int s = 0; s < 8; s++)
+            sum += table[pext_index(net, i, sym[s])];
+    }
+    return sum;
+}
+
+ntuple_eval_f ntuple_eval = eval_generic;
+
+void ntuple_init()
+{
+    ntuple_eval = cpu_has(CPU_BMI2) ? eval_bmi2 : eval_generic;
+}
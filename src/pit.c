@@ -0,0 +1,59 @@
+//
+// pit.c - implementation of pit.h
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+
+#include <stdint.h>
+
+#include "irq.h"
+#include "pit.h"
+#include "ports.h"
+
+static volatile uint32_t ticks;
+
+void pit_init(uint32_t hz)
+{
+    uint32_t divisor = _PIT_FREQUENCY / hz;
+    if (divisor > 0xFFFF)
+        divisor = 0xFFFF;
+    outb(_PIT_COMMAND_REGISTER, _PIT_SELECT_CHAN0 | _PIT_ACCESS_BOTH | 
+                                                        _PIT_RATE_GENERATOR);
+    outb(_PIT_CHANNEL0_DATA, divisor & 0xFF);
+    outb(_PIT_CHANNEL0_DATA, divisor >> 8);
+    ticks = 0;
+    irq_enable(0);
+}
+
+void pit_tick()
+{
+    ticks++;
+}
+
+uint32_t pit_ticks()
+{
+    return ticks;
+}
@@ -44,12 +44,32 @@ uint16_t inw(uint16_t port)
     return ret;
 }
 
+// Read a double word from a port
+uint32_t inl(uint16_t port)
+{
+    uint32_t ret;
+    __asm__ __volatile__ ("inl %1, %0" : "=a" (ret) : "dN" (port));
+    return ret;
+}
+
 // Write a byte to a port
 void outb(uint16_t port, uint8_t value)
 {
     __asm__ __volatile__ ("outb %1, %0" : : "dN" (port), "a" (value));
 }
 
+// Write a word to a port
+void outw(uint16_t port, uint16_t value)
+{
+    __asm__ __volatile__ ("outw %1, %0" : : "dN" (port), "a" (value));
+}
+
+// Write a double word to a port
+void outl(uint16_t port, uint32_t value)
+{
+    __asm__ __volatile__ ("outl %1, %0" : : "dN" (port), "a" (value));
+}
+
 // Wait
 void io_wait()
 {
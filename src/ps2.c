@@ -162,6 +162,16 @@ static uint8_t read(bool* has_timeout)
     return ret;
 }
 
+static bool pending_f()
+{
+    return buf1_len != 0;
+}
+
+static bool pending_s()
+{
+    return buf2_len != 0;
+}
+
 static uint8_t read_f(bool* has_timeout)
 {
     while(buf1_len == 0)
@@ -620,6 +630,7 @@ void ps2_init()
             f.readbyte = read;
             f.wait = wait;
             f.wait_ack = wait_ack_f;
+            f.pending = pending_f;
             f.translated = first.type == _PS2_TYPE_TRANSLATED_AT_KB ||
                                     first.type == _PS2_TYPE_TRANSLATED_MF2_KB;
             kb_add(&f);
@@ -648,6 +659,7 @@ void ps2_init()
             s.readbyte = read;
             s.wait = wait;
             s.wait_ack = wait_ack_s;
+            s.pending = pending_s;
             s.translated = second.type == _PS2_TYPE_TRANSLATED_AT_KB ||
                                     second.type == _PS2_TYPE_TRANSLATED_MF2_KB;
             kb_add(&s);
@@ -0,0 +1,186 @@
+//
+// remote.c - playing over the serial port
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "board.h"
+#include "game.h"
+#include "remote.h"
+
+#define STATE_SYNC      0
+#define STATE_LENGTH    1
+#define STATE_COMMAND   2
+#define STATE_PAYLOAD   3
+#define STATE_CRC       4
+
+static uint8_t crc8(uint8_t crc, uint8_t byte)
+{
+    crc ^= byte;
+    for (int i = 0; i < 8; i++)
+        crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    return crc;
+}
+
+void remote_parser_init(remote_parser_t* parser)
+{
+    parser->state = STATE_SYNC;
+    parser->have = 0;
+    parser->crc = 0;
+}
+
+static int check(const remote_frame_t* frame)
+{
+    switch (frame->command)
+    {
+        case REMOTE_CMD_STATE:
+            return frame->length == 0 ? REMOTE_FRAME : REMOTE_ERR_LENGTH;
+        case REMOTE_CMD_MOVE:
+            if (frame->length != 1)
+                return REMOTE_ERR_LENGTH;
+            return frame->payload[0] < DIR_COUNT ? REMOTE_FRAME : 
+                                                            REMOTE_ERR_DIR;
+        case REMOTE_CMD_RESET:
+            return frame->length == 0 || frame->length == sizeof(uint64_t) ? 
+                                            REMOTE_FRAME : REMOTE_ERR_LENGTH;
+        case REMOTE_CMD_BATCH:
+            if (frame->length < 2 || 
+                    frame->length != 2 + (remote_batch_count(frame) + 3) / 4)
+                return REMOTE_ERR_LENGTH;
+            return REMOTE_FRAME;
+        case REMOTE_CMD_REPLAY:
+            return frame->length == sizeof(uint32_t) ? REMOTE_FRAME : 
+                                                            REMOTE_ERR_LENGTH;
+        case REMOTE_REPLY_STATE:
+            return frame->length == sizeof(remote_state_t) ? REMOTE_FRAME : 
+                                                            REMOTE_ERR_LENGTH;
+        case REMOTE_REPLY_REPLAY:
+            return frame->length >= sizeof(remote_replay_t) ? REMOTE_FRAME : 
+                                                            REMOTE_ERR_LENGTH;
+        case REMOTE_REPLY_ERROR:
+            return frame->length == 1 ? REMOTE_FRAME : REMOTE_ERR_LENGTH;
+        default:
+            return REMOTE_ERR_COMMAND;
+    }
+}
+
+int remote_feed(remote_parser_t* parser, uint8_t byte)
+{
+    remote_frame_t* frame = &parser->frame;
+    switch (parser->state)
+    {
+        case STATE_SYNC:
+            if (byte == REMOTE_SYNC)
+                parser->state = STATE_LENGTH;
+            return REMOTE_NONE;
+        case STATE_LENGTH:
+            frame->length = byte;
+            parser->crc = crc8(0, byte);
+            parser->state = STATE_COMMAND;
+            return REMOTE_NONE;
+        case STATE_COMMAND:
+            frame->command = byte;
+            parser->crc = crc8(parser->crc, byte);
+            parser->have = 0;
+            parser->state = frame->length > 0 ? STATE_PAYLOAD : STATE_CRC;
+            return REMOTE_NONE;
+        case STATE_PAYLOAD:
+            frame->payload[parser->have++] = byte;
+            parser->crc = crc8(parser->crc, byte);
+            if (parser->have == frame->length)
+                parser->state = STATE_CRC;
+            return REMOTE_NONE;
+        default:
+            parser->state = STATE_SYNC;
+            if (byte != parser->crc)
+                return REMOTE_ERR_CHECKSUM;
+            return check(frame);
+    }
+}
+
+size_t remote_encode(uint8_t command, const void* payload, size_t length, 
+                     uint8_t out[REMOTE_MAX_FRAME])
+{
+    if (length > REMOTE_MAX_PAYLOAD)
+        length = REMOTE_MAX_PAYLOAD;
+    out[0] = REMOTE_SYNC;
+    out[1] = length;
+    out[2] = command;
+    memcpy(out + 3, payload, length);
+    uint8_t crc = 0;
+    for (size_t i = 1; i < length + 3; i++)
+        crc = crc8(crc, out[i]);
+    out[length + 3] = crc;
+    return length + 4;
+}
+
+size_t remote_pack_batch(const uint8_t* dirs, int count, 
+                         uint8_t payload[REMOTE_MAX_PAYLOAD])
+{
+    if (count > REMOTE_MAX_BATCH)
+        count = REMOTE_MAX_BATCH;
+    payload[0] = count & 0xFF;
+    payload[1] = count >> 8;
+    size_t length = 2 + (count + 3) / 4;
+    memset(payload + 2, 0, length - 2);
+    for (int i = 0; i < count; i++)
+        payload[2 + i / 4] |= (dirs[i] & 3) << ((i % 4) * 2);
+    return length;
+}
+
+void remote_state(const game_t* game, int applied, remote_state_t* state)
+{
+    state->board = game->board;
+    state->score = game->score;
+    state->applied = applied;
+    state->flags = (game->won ? REMOTE_WON : 0) | 
+                                                (game->lost ? REMOTE_LOST : 0);
+}
+
+const char* remote_strerror(int err)
+{
+    switch(err)
+    {
+        case REMOTE_NONE:
+            return "no frame yet";
+        case REMOTE_FRAME:
+            return "OK";
+        case REMOTE_ERR_CHECKSUM:
+            return "bad checksum";
+        case REMOTE_ERR_COMMAND:
+            return "unknown command";
+        case REMOTE_ERR_LENGTH:
+            return "wrong payload length";
+        case REMOTE_ERR_DIR:
+            return "not a direction";
+        default:
+            return "unknown error";
+    }
+}
@@ -0,0 +1,393 @@
+//
+// replay.c - recorded games
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "board.h"
+#include "game.h"
+#include "replay.h"
+#include "rng.h"
+
+static void flush(replay_writer_t* writer)
+{
+    if (writer->used != 0)
+        writer->write(writer->ctx, writer->buffer, writer->used);
+    writer->used = 0;
+}
+
+static void put(replay_writer_t* writer, const void* data, size_t size)
+{
+    const uint8_t* bytes = data;
+    while (size != 0)
+    {
+        size_t n = REPLAY_BUFFER_SIZE - writer->used;
+        if (n > size)
+            n = size;
+        memcpy(writer->buffer + writer->used, bytes, n);
+        writer->used += n;
+        bytes += n;
+        size -= n;
+        if (writer->used == REPLAY_BUFFER_SIZE)
+            flush(writer);
+    }
+}
+
+void replay_begin(replay_writer_t* writer, replay_write_f write, void* ctx, 
+                  const rng_t* rng)
+{
+    writer->write = write;
+    writer->ctx = ctx;
+    writer->moves = 0;
+    writer->used = 0;
+    
+    replay_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = REPLAY_MAGIC;
+    header.version = REPLAY_VERSION;
+    header.engine = GAME_ENGINE_VERSION;
+    header.interval = REPLAY_INTERVAL;
+    header.state = rng->state;
+    header.inc = rng->inc;
+    put(writer, &header, sizeof(header));
+}
+
+void replay_record(replay_writer_t* writer, board_t before, int dir, 
+                   const game_t* game)
+{
+    // the spawned tile is the only thing the move didn't do
+    board_t spawned = game->board ^ board_move(before, dir, 0);
+    uint32_t low = (uint32_t) spawned;
+    int cell = low != 0 ? __builtin_ctz(low) / 4 : 
+                                8 + __builtin_ctz((uint32_t) (spawned >> 32)) / 4;
+    int value = (game->board >> (cell * 4)) & 0xF;
+    uint8_t byte = dir | cell << 2 | (value - 1) << 6;
+    put(writer, &byte, 1);
+    
+    writer->moves++;
+    if (writer->moves % REPLAY_INTERVAL == 0)
+    {
+        replay_checkpoint_t checkpoint;
+        checkpoint.board = game->board;
+        checkpoint.score = game->score;
+        checkpoint.state = game->rng.state;
+        put(writer, &checkpoint, sizeof(checkpoint));
+    }
+}
+
+void replay_finish(replay_writer_t* writer, const game_t* game)
+{
+    replay_end_t end;
+    end.marker = REPLAY_END;
+    end.moves = writer->moves;
+    end.board = game->board;
+    end.score = game->score;
+    put(writer, &end, sizeof(end));
+    flush(writer);
+}
+
+int replay_open(replay_reader_t* reader, const void* data, size_t size)
+{
+    const replay_header_t* header = data;
+    if (size < sizeof(replay_header_t))
+        return REPLAY_ERR_SIZE;
+    if (header->magic != REPLAY_MAGIC)
+        return REPLAY_ERR_MAGIC;
+    if (header->version != REPLAY_VERSION)
+        return REPLAY_ERR_VERSION;
+    if (header->interval == 0 || (header->inc & 1) == 0)
+        return REPLAY_ERR_CORRUPT;
+    
+    reader->data = data;
+    reader->size = size;
+    reader->pos = sizeof(replay_header_t);
+    reader->engine = header->engine;
+    reader->interval = header->interval;
+    reader->rng.state = header->state;
+    reader->rng.inc = header->inc;
+    reader->moves = 0;
+    return REPLAY_OK;
+}
+
+int replay_next(replay_reader_t* reader, replay_move_t* move)
+{
+    if (reader->pos >= reader->size)
+        return REPLAY_ERR_SIZE;
+    uint8_t byte = reader->data[reader->pos];
+    
+    if (byte == REPLAY_END)
+    {
+        if (reader->size - reader->pos < sizeof(replay_end_t))
+            return REPLAY_ERR_SIZE;
+        memcpy(&reader->end, reader->data + reader->pos, sizeof(replay_end_t));
+        if (reader->end.moves != reader->moves)
+            return REPLAY_ERR_CORRUPT;
+        reader->pos += sizeof(replay_end_t);
+        return REPLAY_DONE;
+    }
+    if (byte & 0x80)
+        return REPLAY_ERR_CORRUPT;
+    
+    move->dir = byte & 3;
+    move->cell = (byte >> 2) & 0xF;
+    move->value = (byte >> 6) + 1;
+    reader->pos++;
+    reader->moves++;
+    
+    // the checkpoint is only needed for seeking, replay_step checks it
+    if (reader->moves % reader->interval == 0)
+    {
+        if (reader->size - reader->pos < sizeof(replay_checkpoint_t))
+            return REPLAY_ERR_SIZE;
+        reader->pos += sizeof(replay_checkpoint_t);
+    }
+    return REPLAY_OK;
+}
+
+void replay_start(const replay_reader_t* reader, game_t* game)
+{
+    game->rng = reader->rng;
+    game_reset(game);
+}
+
+int replay_step(replay_reader_t* reader, game_t* game)
+{
+    replay_move_t move;
+    int err = replay_next(reader, &move);
+    if (err == REPLAY_DONE && (game->board != reader->end.board || 
+                                            game->score != reader->end.score))
+        return REPLAY_ERR_STATE;
+    if (err != REPLAY_OK)
+        return err;
+    
+    uint32_t score = 0;
+    board_t moved = board_move(game->board, move.dir, &score);
+    if (!game_play(game, moved, score))
+        return REPLAY_ERR_ILLEGAL;
+    if (game->board != (moved | (board_t) move.value << (move.cell * 4)))
+        return REPLAY_ERR_SPAWN;
+    
+    if (reader->moves % reader->interval == 0)
+    {
+        replay_checkpoint_t checkpoint;
+        memcpy(&checkpoint, reader->data + reader->pos - sizeof(checkpoint), 
+                                                            sizeof(checkpoint));
+        if (game->board != checkpoint.board || 
+                                        game->score != checkpoint.score || 
+                                        game->rng.state != checkpoint.state)
+            return REPLAY_ERR_STATE;
+    }
+    return REPLAY_OK;
+}
+
+int replay_seek(replay_reader_t* reader, game_t* game, uint32_t move)
+{
+    reader->pos = sizeof(replay_header_t);
+    reader->moves = 0;
+    
+    // checkpoint k only exists if the k intervals before it were all moves
+    uint32_t k = 0;
+    while (k < move / reader->interval)
+    {
+        size_t next = reader->pos + reader->interval + 
+                                                sizeof(replay_checkpoint_t);
+        if (next > reader->size)
+            break;
+        const uint8_t* bytes = reader->data + reader->pos;
+        uint32_t i = 0;
+        while (i < reader->interval && !(bytes[i] & 0x80))
+            i++;
+        if (i < reader->interval)
+            break;
+        reader->pos = next;
+        reader->moves += reader->interval;
+        k++;
+    }
+    
+    if (k == 0)
+        replay_start(reader, game);
+    else
+    {
+        replay_checkpoint_t checkpoint;
+        memcpy(&checkpoint, reader->data + reader->pos - sizeof(checkpoint), 
+                                                            sizeof(checkpoint));
+        game->board = checkpoint.board;
+        game->score = checkpoint.score;
+        game->rng.state = checkpoint.state;
+        game->rng.inc = reader->rng.inc;
+        game->won = board_max_tile(game->board) >= GAME_WIN_TILE;
+        game->lost = !board_can_move(game->board);
+    }
+    
+    while (reader->moves < move)
+    {
+        int err = replay_step(reader, game);
+        if (err != REPLAY_OK)
+            return err;
+    }
+    return REPLAY_OK;
+}
+
+size_t replay_length(const void* data, size_t size)
+{
+    replay_reader_t reader;
+    replay_move_t move;
+    int err = replay_open(&reader, data, size);
+    while (err == REPLAY_OK)
+        err = replay_next(&reader, &move);
+    return err == REPLAY_DONE ? reader.pos : 0;
+}
+
+int replay_verify(const void* data, size_t size, replay_check_t* check)
+{
+    check->moves = 0;
+    check->score = 0;
+    check->engine = 0;
+    check->size = 0;
+    
+    replay_reader_t reader;
+    check->err = replay_open(&reader, data, size);
+    if (check->err != REPLAY_OK)
+        return check->err;
+    check->engine = reader.engine;
+    
+    // replay_step without the reader and game_play around it, won and lost
+    // only matter for the UI
+    game_t game;
+    replay_start(&reader, &game);
+    board_t board = game.board;
+    rng_t rng = game.rng;
+    uint64_t score = 0;
+    uint32_t moves = 0;
+    const uint8_t* bytes = reader.data;
+    size_t pos = reader.pos;
+    int err = REPLAY_OK;
+    for (;;)
+    {
+        if (pos >= size)
+        {
+            err = REPLAY_ERR_SIZE;
+            break;
+        }
+        uint8_t byte = bytes[pos];
+        if (byte == REPLAY_END)
+        {
+            replay_end_t end;
+            if (size - pos < sizeof(end))
+            {
+                err = REPLAY_ERR_SIZE;
+                break;
+            }
+            memcpy(&end, bytes + pos, sizeof(end));
+            if (end.moves != moves || end.board != board || 
+                                                        end.score != score)
+                err = REPLAY_ERR_STATE;
+            else
+                check->size = pos + sizeof(end);
+            break;
+        }
+        if (byte & 0x80)
+        {
+            err = REPLAY_ERR_CORRUPT;
+            break;
+        }
+        
+        uint32_t reward = 0;
+        board_t moved = board_move(board, byte & 3, &reward);
+        if (moved == board)
+        {
+            err = REPLAY_ERR_ILLEGAL;
+            break;
+        }
+        board = board_spawn(moved, &rng);
+        int cell = (byte >> 2) & 0xF;
+        if (board != (moved | (board_t) ((byte >> 6) + 1) << (cell * 4)))
+        {
+            err = REPLAY_ERR_SPAWN;
+            break;
+        }
+        score += reward;
+        pos++;
+        moves++;
+        
+        if (moves % reader.interval == 0)
+        {
+            replay_checkpoint_t checkpoint;
+            if (size - pos < sizeof(checkpoint))
+            {
+                err = REPLAY_ERR_SIZE;
+                break;
+            }
+            memcpy(&checkpoint, bytes + pos, sizeof(checkpoint));
+            if (checkpoint.board != board || checkpoint.score != score || 
+                                                checkpoint.state != rng.state)
+            {
+                // the move itself was fine, it's what came of it
+                moves--;
+                err = REPLAY_ERR_STATE;
+                break;
+            }
+            pos += sizeof(checkpoint);
+        }
+    }
+    
+    check->err = err;
+    check->moves = moves;
+    check->score = score;
+    return err;
+}
+
+const char* replay_strerror(int err)
+{
+    switch(err)
+    {
+        case REPLAY_OK:
+            return "OK";
+        case REPLAY_DONE:
+            return "game over";
+        case REPLAY_ERR_SIZE:
+            return "replay is truncated";
+        case REPLAY_ERR_MAGIC:
+            return "not a replay";
+        case REPLAY_ERR_VERSION:
+            return "unsupported version";
+        case REPLAY_ERR_CORRUPT:
+            return "corrupt replay";
+        case REPLAY_ERR_ILLEGAL:
+            return "move doesn't move anything";
+        case REPLAY_ERR_SPAWN:
+            return "different tile spawned";
+        case REPLAY_ERR_STATE:
+            return "game differs from the recording";
+        default:
+            return "unknown error";
+    }
+}
@@ -0,0 +1,80 @@
+//
+// rng.c - implementation of rng.h
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rng.h"
+
+void rng_seed(rng_t* rng, uint64_t seed)
+{
+    rng_seed_stream(rng, seed, 0);
+}
+
+// the reference pcg32_srandom_r
+void rng_seed_stream(rng_t* rng, uint64_t seed, uint64_t stream)
+{
+    rng->state = 0;
+    rng->inc = (stream << 1) | 1;
+    rng_next(rng);
+    rng->state += seed;
+    rng_next(rng);
+}
+
+void rng_fill(rng_t* rng, uint32_t* buf, size_t count)
+{
+    // keeping the state in a local lets the compiler keep it in registers
+    // instead of storing it back after every value
+    rng_t local = *rng;
+    for (size_t i = 0; i < count; i++)
+        buf[i] = rng_next(&local);
+    *rng = local;
+}
+
+// Brown's "Random Number Generation with Arbitrary Strides", like the
+// reference pcg32_advance_r. Going back is going almost 2^64 ahead.
+void rng_advance(rng_t* rng, int64_t delta)
+{
+    uint64_t steps = (uint64_t) delta;
+    uint64_t mult = RNG_MULTIPLIER;
+    uint64_t plus = rng->inc;
+    uint64_t acc_mult = 1;
+    uint64_t acc_plus = 0;
+    while (steps != 0)
+    {
+        if (steps & 1)
+        {
+            acc_mult *= mult;
+            acc_plus = acc_plus * mult + plus;
+        }
+        plus = (mult + 1) * plus;
+        mult *= mult;
+        steps >>= 1;
+    }
+    rng->state = acc_mult * rng->state + acc_plus;
+}
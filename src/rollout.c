@@ -0,0 +1,135 @@
+//
+// rollout.c - implementation of rollout.h
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+
+#include <stdint.h>
+
+#include "board.h"
+#include "rng.h"
+#include "rollout.h"
+#include "tsc.h"
+
+void rollout_clear(rollout_sums_t* sums)
+{
+    for (int dir = 0; dir < DIR_COUNT; dir++)
+        sums->score[dir] = 0;
+    sums->steps = 0;
+}
+
+// random legal moves from board until it's over or depth moves were made,
+// returns what they scored
+static uint32_t play_out(board_t board, uint32_t depth, rng_t* rng, 
+                                                            uint64_t* steps)
+{
+    uint32_t total = 0;
+    uint32_t moves = 0;
+    for (;;)
+    {
+        if (depth != 0 && moves == depth)
+            break;
+        
+        board_t after[DIR_COUNT];
+        uint32_t score[DIR_COUNT];
+        board_move_all(board, after, score);
+        int legal[DIR_COUNT];
+        int count = 0;
+        for (int dir = 0; dir < DIR_COUNT; dir++)
+            if (after[dir] != board)
+                legal[count++] = dir;
+        if (count == 0)
+            break;
+        
+        int dir = legal[rng_below(rng, count)];
+        total += score[dir];
+        board = board_spawn(after[dir], rng);
+        moves++;
+    }
+    *steps += moves;
+    return total;
+}
+
+void rollout_work(board_t board, const rollout_limits_t* limits, 
+                  uint32_t count, rng_t* rng, rollout_sums_t* sums)
+{
+    board_t after[DIR_COUNT];
+    uint32_t score[DIR_COUNT];
+    board_move_all(board, after, score);
+    
+    for (int dir = 0; dir < DIR_COUNT; dir++)
+    {
+        if (after[dir] == board)
+            continue;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            board_t spawned = board_spawn(after[dir], rng);
+            sums->score[dir] += score[dir] + 
+                            play_out(spawned, limits->depth, rng, &sums->steps);
+        }
+    }
+}
+
+void rollout_finish(board_t board, const rollout_limits_t* limits, 
+                    const rollout_sums_t* sums, int workers, 
+                    rollout_result_t* result)
+{
+    result->dir = -1;
+    result->value = 0;
+    result->rollouts = 0;
+    result->steps = 0;
+    for (int w = 0; w < workers; w++)
+        result->steps += sums[w].steps;
+    
+    for (int dir = 0; dir < DIR_COUNT; dir++)
+    {
+        result->values[dir] = 0;
+        if (board_move(board, dir, 0) == board)
+            continue;
+        uint64_t total = 0;
+        for (int w = 0; w < workers; w++)
+            total += sums[w].score[dir];
+        if (limits->rollouts != 0)
+            result->values[dir] = (float) total / limits->rollouts;
+        result->rollouts += limits->rollouts;
+        if (result->dir < 0 || result->values[dir] > result->value)
+        {
+            result->dir = dir;
+            result->value = result->values[dir];
+        }
+    }
+}
+
+void rollout_run(board_t board, const rollout_limits_t* limits, rng_t* rng, 
+                 rollout_result_t* result)
+{
+    uint64_t start = tsc_read();
+    rollout_sums_t sums;
+    rollout_clear(&sums);
+    rollout_work(board, limits, limits->rollouts, rng, &sums);
+    rollout_finish(board, limits, &sums, 1, result);
+    result->us = tsc_to_us(tsc_read() - start);
+}
@@ -0,0 +1,263 @@
+//
+// search.c - implementation of search.h
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "board.h"
+#include "eval.h"
+#include "rng.h"
+#include "search.h"
+#include "tsc.h"
+
+void search_init(search_t* search, search_entry_t* table, uint32_t table_size)
+{
+    memset(table, 0, table_size * sizeof(search_entry_t));
+    search->table = table;
+    search->mask = table_size - 1;
+    search->generation = 1;
+    search->deadline = 0;
+    search->abort = 0;
+    search->min_prob = 0;
+    search->sample_cells = 0;
+    search->nodes = 0;
+    search->cutoffs = 0;
+    search->aborted = false;
+    rng_seed(&search->rng, 420);
+}
+
+void search_clear(search_t* search)
+{
+    search->generation++;
+    // wrapped, the oldest entries would look new again
+    if (search->generation == 0)
+    {
+        memset(search->table, 0, (search->mask + 1) * sizeof(search_entry_t));
+        search->generation = 1;
+    }
+}
+
+static inline search_entry_t* lookup(search_t* search, board_t board)
+{
+    uint32_t hash = (uint32_t) ((board * 0x9E3779B97F4A7C15ULL) >> 32);
+    return &search->table[hash & search->mask];
+}
+
+// -log2(prob) rounded up, straight from the exponent
+static inline uint8_t rarity(float prob)
+{
+    union { float f; uint32_t u; } bits = { prob };
+    int exp = 127 - (int) ((bits.u >> 23) & 0xFF);
+    return exp > 0 ? exp : 0;
+}
+
+static float chance(search_t* search, board_t board, int depth, float prob);
+
+// the player moves, the value of a lost position is 0
+static float max_node(search_t* search, board_t board, int depth, float prob)
+{
+    board_t after[DIR_COUNT];
+    uint32_t reward[DIR_COUNT];
+    board_move_all(board, after, reward);
+    
+    float best = 0;
+    for (int dir = 0; dir < DIR_COUNT; dir++)
+    {
+        if (after[dir] == board)
+            continue;
+        float value = reward[dir] + chance(search, after[dir], depth, prob);
+        if (search->aborted)
+            return 0;
+        if (value > best)
+            best = value;
+    }
+    return best;
+}
+
+// a tile spawns, depth is how many more moves to look at and prob is how
+// likely it is that we get here at all
+static float chance(search_t* search, board_t board, int depth, float prob)
+{
+    search->nodes++;
+    if ((search->nodes & (SEARCH_CHECK_INTERVAL - 1)) == 0 && 
+                ((search->deadline != 0 && tsc_read() > search->deadline) || 
+                (search->abort != 0 && search->abort())))
+    {
+        search->aborted = true;
+        return 0;
+    }
+    
+    if (depth == 0)
+        return eval_board(board);
+    if (prob < search->min_prob)
+    {
+        search->cutoffs++;
+        return eval_board(board);
+    }
+    
+    search_entry_t* entry = lookup(search, board);
+    bool current = entry->generation == search->generation;
+    if (current && entry->board == board && entry->depth >= depth && 
+                                            rarity(prob) >= entry->rarity)
+        return entry->value;
+    uint32_t cutoffs = search->cutoffs;
+    
+    int count = 0;
+    int empties[16];
+    for (uint32_t mask = board_empty_mask(board); mask != 0; mask &= mask - 1)
+    {
+        empties[count] = __builtin_ctz(mask);
+        count++;
+    }
+    
+    // the first sample_cells of a partial shuffle are a fair sample
+    if (search->sample_cells > 0 && count > search->sample_cells)
+    {
+        for (int i = 0; i < search->sample_cells; i++)
+        {
+            int j = i + rng_below(&search->rng, count - i);
+            int tmp = empties[i];
+            empties[i] = empties[j];
+            empties[j] = tmp;
+        }
+        count = search->sample_cells;
+    }
+    
+    float sum = 0;
+    float cell_prob = count ? prob / count : 0;
+    for (int k = 0; k < count; k++)
+    {
+        int i = empties[k];
+        sum += 0.9f * max_node(search, board | ((board_t) 1 << (i * 4)), 
+                                                depth - 1, cell_prob * 0.9f);
+        sum += 0.1f * max_node(search, board | ((board_t) 2 << (i * 4)), 
+                                                depth - 1, cell_prob * 0.1f);
+        if (search->aborted)
+            return 0;
+    }
+    float value = count ? sum / count : 0;
+    
+    if (!current || entry->depth <= depth)
+    {
+        entry->board = board;
+        entry->value = value;
+        entry->depth = depth;
+        entry->rarity = search->cutoffs != cutoffs ? rarity(prob) : 0;
+        entry->generation = search->generation;
+    }
+    return value;
+}
+
+void search_run(search_t* search, board_t board, 
+                        const search_limits_t* limits, search_result_t* result)
+{
+    uint64_t start = tsc_read();
+    uint64_t deadline = limits->budget_us ? 
+                                    start + tsc_from_us(limits->budget_us) : 0;
+    // what's in the table was searched with other limits
+    if (limits->min_prob != search->min_prob || 
+                                limits->sample_cells != search->sample_cells)
+        search_clear(search);
+    search->min_prob = limits->min_prob;
+    search->sample_cells = limits->sample_cells;
+    search->nodes = 0;
+    search->cutoffs = 0;
+    search->aborted = false;
+    
+    result->dir = -1;
+    result->value = 0;
+    result->depth = 0;
+    
+    // root moves, best first from the previous iteration
+    int order[DIR_COUNT];
+    board_t* after = result->after;
+    uint32_t* reward = result->reward;
+    float value[DIR_COUNT];
+    int legal = 0;
+    board_move_all(board, after, reward);
+    for (int dir = 0; dir < DIR_COUNT; dir++)
+    {
+        result->values[dir] = 0;
+        if (after[dir] != board)
+        {
+            order[legal] = dir;
+            legal++;
+        }
+    }
+    
+    int max_depth = limits->max_depth;
+    if (max_depth > SEARCH_MAX_DEPTH || max_depth < 1)
+        max_depth = SEARCH_MAX_DEPTH;
+    
+    for (int depth = 1; depth <= max_depth && legal > 0; depth++)
+    {
+        uint64_t iteration = tsc_read();
+        // 1 always finishes
+        search->deadline = depth > 1 ? deadline : 0;
+        search->abort = depth > 1 ? limits->abort : 0;
+        for (int i = 0; i < legal; i++)
+        {
+            int dir = order[i];
+            value[dir] = reward[dir] + chance(search, after[dir], depth - 1, 
+                                                                        1.0f);
+            if (search->aborted)
+                break;
+        }
+        if (search->aborted)
+            break;
+        
+        // insertion sort, it's 4 moves at most
+        for (int i = 1; i < legal; i++)
+        {
+            int dir = order[i];
+            int j = i;
+            for (; j > 0 && value[order[j - 1]] < value[dir]; j--)
+                order[j] = order[j - 1];
+            order[j] = dir;
+        }
+        
+        result->dir = order[0];
+        result->value = value[order[0]];
+        result->depth = depth;
+        for (int i = 0; i < legal; i++)
+            result->values[order[i]] = value[order[i]];
+        
+        if (deadline != 0)
+        {
+            uint64_t now = tsc_read();
+            if (now >= deadline || 
+                            (deadline - now) / SEARCH_GROWTH < now - iteration)
+                break;
+        }
+    }
+    
+    result->nodes = search->nodes;
+    result->cutoffs = search->cutoffs;
+    result->us = tsc_to_us(tsc_read() - start);
+}
@@ -0,0 +1,204 @@
+//
+// serial.c - COM1 output
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "irq.h"
+#include "ports.h"
+#include "serial.h"
+
+// 8 KiB is a bit more than everything printed while booting
+#define TX_SIZE     8192
+
+static char tx[TX_SIZE];
+static volatile uint32_t tx_head;   // written by serial_putc
+static volatile uint32_t tx_tail;   // written by whoever fills the FIFO
+static size_t dropped;
+
+// what came in, read by serial_read
+#define RX_SIZE     1024
+
+static uint8_t rx[RX_SIZE];
+static volatile uint32_t rx_head;   // written by the interrupt
+static volatile uint32_t rx_tail;   // written by serial_read
+
+// 0 until serial_init finds a UART, the queue just fills up until then
+static uint16_t port;
+static bool tx_irq;                 // whether the empty FIFO interrupt is on
+static bool absent;                 // nothing to queue for
+
+// cli, returns what EFLAGS were before
+static uint32_t interrupts_off()
+{
+    uint32_t flags;
+    asm volatile("pushf\n"
+                 "pop %0\n"
+                 "cli" : "=r" (flags) : : "memory");
+    return flags;
+}
+
+static void interrupts_restore(uint32_t flags)
+{
+    asm volatile("push %0\n"
+                 "popf" : : "r" (flags) : "memory", "cc");
+}
+
+// Up to a FIFO's worth if the UART has room for it, never waits. The
+// interrupt is on for as long as there's something left, when the FIFO is
+// still busy it comes once it's empty. Has to be called with interrupts off.
+static void fill_fifo()
+{
+    if (port == 0)
+        return;
+    if (inb(port + _UART_LINE_STATUS) & _UART_LINE_TX_EMPTY)
+    {
+        for (int i = 0; i < _UART_FIFO_SIZE && tx_tail != tx_head; i++)
+        {
+            outb(port + _UART_DATA, tx[tx_tail % TX_SIZE]);
+            tx_tail++;
+        }
+    }
+    bool want = tx_tail != tx_head;
+    if (want != tx_irq)
+    {
+        tx_irq = want;
+        outb(port + _UART_INTERRUPT_ENABLE, _UART_INT_RX_READY | 
+                                            (want ? _UART_INT_TX_EMPTY : 0));
+    }
+}
+
+bool serial_init(uint32_t baud)
+{
+    uint16_t base = _COM1_BASE;
+    if (baud == 0 || baud > _UART_CLOCK)
+        baud = _UART_CLOCK;
+    uint16_t divisor = _UART_CLOCK / baud;
+    
+    outb(base + _UART_INTERRUPT_ENABLE, 0);
+    outb(base + _UART_LINE_CONTROL, _UART_DLAB);
+    outb(base + _UART_DIVISOR_LOW, divisor & 0xFF);
+    outb(base + _UART_DIVISOR_HIGH, divisor >> 8);
+    outb(base + _UART_LINE_CONTROL, _UART_8N1);
+    outb(base + _UART_FIFO_CONTROL, _UART_FIFO_ENABLE | _UART_FIFO_CLEAR_RX | 
+                                _UART_FIFO_CLEAR_TX | _UART_FIFO_TRIGGER_14);
+    
+    // something has to come back in loopback, no UART reads as all 1s
+    outb(base + _UART_MODEM_CONTROL, _UART_MODEM_LOOPBACK | _UART_MODEM_RTS | 
+                                                            _UART_MODEM_OUT2);
+    outb(base + _UART_DATA, 0xAE);
+    for (int i = 0; i < 1000 && 
+                !(inb(base + _UART_LINE_STATUS) & _UART_LINE_RX_READY); i++)
+        io_wait();
+    if (inb(base + _UART_DATA) != 0xAE)
+    {
+        absent = true;
+        tx_tail = tx_head;
+        return false;
+    }
+    
+    outb(base + _UART_MODEM_CONTROL, _UART_MODEM_DTR | _UART_MODEM_RTS | 
+                                                            _UART_MODEM_OUT2);
+    uint32_t flags = interrupts_off();
+    // whatever the loopback left in there isn't from anyone
+    while (inb(base + _UART_LINE_STATUS) & _UART_LINE_RX_READY)
+        inb(base + _UART_DATA);
+    port = base;
+    tx_irq = false;
+    outb(base + _UART_INTERRUPT_ENABLE, _UART_INT_RX_READY);
+    irq_enable(4);
+    fill_fifo();
+    interrupts_restore(flags);
+    return true;
+}
+
+void serial_putc(char c)
+{
+    if (absent)
+        return;
+    if (tx_head - tx_tail >= TX_SIZE)
+    {
+        dropped++;
+        return;
+    }
+    tx[tx_head % TX_SIZE] = c;
+    
+    // With interrupts off (before sti or in a handler) there's nothing to
+    // take it from the queue but this. With them on, the interrupt has to be
+    // turned on before the handler can look at the queue again.
+    uint32_t flags = interrupts_off();
+    tx_head++;
+    if (!tx_irq || !(flags & (1 << 9)))
+        fill_fifo();
+    interrupts_restore(flags);
+}
+
+void serial_write(const void* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        serial_putc(((const char*) data)[i]);
+}
+
+bool serial_pending()
+{
+    return rx_tail != rx_head;
+}
+
+bool serial_read(uint8_t* byte)
+{
+    if (rx_tail == rx_head)
+        return false;
+    *byte = rx[rx_tail % RX_SIZE];
+    rx_tail++;
+    return true;
+}
+
+void serial_irq()
+{
+    if (port == 0)
+        return;
+    // reading the ID acknowledges the empty FIFO interrupt, reading the data
+    // the one for received bytes. Those that don't fit are lost.
+    inb(port + _UART_INTERRUPT_ID);
+    while (inb(port + _UART_LINE_STATUS) & _UART_LINE_RX_READY)
+    {
+        uint8_t byte = inb(port + _UART_DATA);
+        if (rx_head - rx_tail < RX_SIZE)
+        {
+            rx[rx_head % RX_SIZE] = byte;
+            rx_head++;
+        }
+    }
+    fill_fifo();
+}
+
+size_t serial_dropped()
+{
+    return dropped;
+}
@@ -33,10 +33,18 @@
 
 #ifdef __kernel__
 
+#include "board.h"
+#include "cpu.h"
+#include "gfx.h"
+#include "ports.h"
+#include "serial.h"
 #include "string.h"
+#include "tsc.h"
+#include "vga.h"
 
-#define _VGA_WIDTH  80
-#define _VGA_HEIGHT 25
+// the biggest text mode, the one in use is text_width x text_height
+#define _VGA_MAX_WIDTH  90
+#define _VGA_MAX_HEIGHT 60
 
 #define _VGA_BLACK          0
 #define _VGA_BLUE           1
@@ -55,24 +63,67 @@
 #define _VGA_LIGHTBROWN     14
 #define _VGA_WHITE          15
 
-void outb(uint16_t port, uint8_t value);
-
-// 0x03D0 - 0x3DF -- CGA (Color Graphics Adapter)
-#define _VGA_SELECT_REGISTER        0x03D4
-#define _VGA_REGISTER_CURSORSTART   0x0A
-#define _VGA_DATA_CURSOROFF         (1<<5)
-#define _VGA_REGISTER_CURSOREND     0x0B
-#define _VGA_REGISTER_CURSORLOCHIGH 0x0E
-#define _VGA_REGISTER_CURSORLOCLOW  0x0F
-#define _VGA_DATA_REGISTER          0x03D5
+// Text memory has room for 8 pages at 80x25, 3 are used. The game is drawn
+// into one that isn't on the screen and the CRTC is told to show that one 
+// instead. It only takes that at the start of the next vertical retrace, so
+// until then the old page can still be on the screen, hence the third one.
+// At 90x60 only two fit, a frame waits for the flip before it then.
+#define _VGA_MEMORY     ((uint16_t *) 0xB8000)
+#define _VGA_MEMORY_SIZE 16384      /* characters, 32 KiB */
+#define _VGA_MAX_PAGES  3
+// how long to wait for a retrace that may never come (no VGA at all)
+#define _VGA_RETRACE_TIMEOUT_US 50000
 
 static uint16_t cursor_y;
 static uint16_t cursor_x;
 
+// the text mode, set by _text_init and _text_mode
+static uint16_t text_width;
+static uint16_t text_height;
+static uint16_t page_size;          // characters, a multiple of 256
+static int page_count;
+static uint16_t console_end;        // where the console goes back to 0
+
 #define attrib (_VGA_BLACK << 4) | (_VGA_LIGHTGRAY)
 
+// the page that's drawn into, the console is the shown one until the game
+// draws its first frame
 static uint16_t *video_mem;
 
+// Until then the console scrolls by moving the start of the screen down a
+// line at a time through all of text memory, and only copies the screen
+// back to the start when it gets to the end. console_top is where it is.
+static bool console;
+static uint16_t console_top;
+
+static int shown_page;
+static int pending_page;            // -1 if the last flip has been taken
+static uint64_t flip_tsc;
+static uint64_t frame_ticks;        // a bit more than a frame, 0 if unknown
+
+// Frames are drawn here first and copied to a page by _text_present, so
+// frames of sliding tiles can start from the last one without reading text
+// memory back. It's kept from one frame to the next, see the fields below.
+// shadow_tiles are where its tiles are, shadow_mask which cells have one.
+static uint16_t shadow[_VGA_MAX_WIDTH * _VGA_MAX_HEIGHT];
+static char* shadow_map;
+static uint16_t shadow_tiles[16];
+static uint8_t shadow_values[16];
+static int shadow_tile_count;
+static uint16_t shadow_mask;
+
+// With graphics the pages aren't used at all, everything is drawn into the
+// shadow and slide frames are just a list of tiles
+static gfx_tile_t slide_tiles[16];
+static int slide_tile_count;
+static bool sliding;
+
+// which fields of the shadow each page doesn't have yet, and where tiles
+// were put on top of it since
+static uint32_t page_dirty[_VGA_MAX_PAGES];
+static uint16_t page_tiles[_VGA_MAX_PAGES][16];
+static int page_tile_count[_VGA_MAX_PAGES];
+
 static uint16_t blank;
 
 static bool alternate;
@@ -80,6 +131,53 @@ static bool alternate;
 #define MAP_WIDTH 21*2
 #define MAP_HEIGHT 9
 
+// Everything that changes has a place of its own on the screen and is only
+// written again when what it shows does, the rest is drawn once. A bit
+// each in page_dirty, the tiles are the cells of the board.
+#define _FIELD_SCORE    16
+#define _FIELD_HIGH     17
+#define _FIELD_STATUS   18
+#define _FIELD_AI       19          // two lines, the move and the search
+#define _FIELD_DASH     20          // three lines, with 50 lines and more
+#define _DIRTY_ALL      (1u << 21)  // the whole screen
+
+#define _FIELD_COL      (MAP_WIDTH / 2 + 2)
+
+// what the fields in the shadow show now
+static bool ui_drawn;               // false until the static text is there
+static uint16_t ui_cursor_x;        // where the static text left the cursor
+static uint16_t ui_cursor_y;
+static board_t ui_board;
+static uint64_t ui_score;
+static uint64_t ui_highscore;
+static int ui_status;               // 0 playing, 1 won, 2 lost
+static struct
+{
+    bool shown;
+    bool drawn;                     // in this frame
+    const char* name;
+    int dir;
+    int depth;
+    uint32_t nodes;
+    uint32_t us;
+    bool autoplay;
+} ui_ai;
+static struct
+{
+    bool shown;
+    uint32_t fps;
+    uint32_t moves;
+    uint32_t nodes;
+    uint32_t cells;
+} ui_dash;
+
+// the row of the dashboard's title under the instructions, 0 if there's no
+// room for one
+static uint16_t dash_row;
+
+// characters written to text memory, for the dashboard
+static uint32_t copied;
+
 // from code page 437
 
 // double up left corner - 201
@@ -138,45 +236,212 @@ char alt_map[MAP_HEIGHT * MAP_WIDTH] = {
 #define col4096 (_VGA_MAGENTA << 4) | _VGA_WHITE
 #define col8192 (_VGA_BROWN   << 4) | _VGA_WHITE
 
-char text[13][8] = {
-    {' ', col2,    ' ', col2,    '2', col2,    ' ', col2},      // 1
-    {' ', col4,    ' ', col4,    '4', col4,    ' ', col4},      // 2
-    {' ', col8,    ' ', col8,    '8', col8,    ' ', col8},      // 3
-    {' ', col16,   '1', col16,   '6', col16,   ' ', col16},     // 4
-    {' ', col32,   '3', col32,   '2', col32,   ' ', col32},     // 5
-    {' ', col64,   '6', col64,   '4', col64,   ' ', col64},     // 6
-    {' ', col128,  '1', col128,  '2', col128,  '8', col128},    // 7
-    {' ', attrib,  '2', col256,  '5', col256,  '6', col256},    // 8
-    {' ', attrib,  '5', col512,  '1', col512,  '2', col512},    // 9
-    {'1', col1024, '0', col1024, '2', col1024, '4', col1024},   // 10
-    {'2', col2048, '0', col2048, '4', col2048, '8', col2048},   // 11
-    {'4', col4096, '0', col4096, '9', col4096, '6', col4096},   // 12
-    {'8', col8192, '1', col8192, '9', col8192, '2', col8192}    // 13
-}; // I won't go further than this so sorry if someone's game crashes 
+#define col16k  (_VGA_LIGHTGRAY << 4) | _VGA_BLACK
+#define col32k  (_VGA_LIGHTGRAY << 4) | _VGA_BLUE
+
+// biggest exponent there is, a nibble of board_t and board.c never merges 
+// two of them
+#define _TILE_MAX   15
+
+static const uint8_t tile_colors[_TILE_MAX + 1] = {
+    attrib, col2, col4, col8, col16, col32, col64, col128, col256, col512, 
+    col1024, col2048, col4096, col8192, col16k, col32k
+};
+
+// the 4 characters of a tile as they go into text memory, built by
+// _build_tiles. 8 bytes apart so every one is a single load.
+static uint64_t tile_cells[_TILE_MAX + 1] __attribute__((aligned(8)));
+
+// a tile doesn't start on 8 bytes in text memory, this tells the compiler
+// that's fine and that it's the same memory as the uint16_t's
+typedef uint64_t __attribute__((may_alias, aligned(2))) _cells_t;
 
 static inline uint16_t _entry(uint8_t c, uint8_t attr)
 {
     return ((uint16_t) c) | (((uint16_t) attr) << 8);
 }
 
+// "  2 ", " 16 ", " 128", "1024" and 16384 and 32768 as " 16k" and " 32k",
+// only the digits get the tile's color
+static uint64_t _tile_run(const char* digits, int len, uint8_t color)
+{
+    uint64_t run = 0;
+    int pad = (4 - len + 1) / 2;
+    for (int i = 0; i < 4; i++)
+    {
+        bool digit = i >= pad && i < pad + len;
+        uint16_t entry = _entry(digit ? digits[i - pad] : ' ', 
+                                                    digit ? color : attrib);
+        run |= (uint64_t) entry << (i * 16);
+    }
+    return run;
+}
+
+static void _build_tiles()
+{
+    tile_cells[0] = _tile_run("", 0, attrib);
+    for (int tile = 1; tile <= _TILE_MAX; tile++)
+    {
+        char digits[8];
+        int len = 0;
+        uint32_t value = 1u << tile;
+        if (value >= 16384)
+            value /= 1024;
+        for (uint32_t n = value; n != 0; n /= 10)
+            len++;
+        for (int i = len - 1, n = value; i >= 0; i--, n /= 10)
+            digits[i] = '0' + n % 10;
+        if (value != 1u << tile)
+            digits[len++] = 'k';
+        tile_cells[tile] = _tile_run(digits, len, tile_colors[tile]);
+    }
+}
+
+// The tile for an exponent, the mask keeps anything past the table from
+// ever being read
+static inline uint64_t _tile_cells(int tile)
+{
+    return tile_cells[tile & _TILE_MAX];
+}
+
+__attribute__((target("sse2")))
+static void _store_cells_sse2(uint16_t* dst, uint64_t cells)
+{
+    asm volatile ("movq %1, %%xmm0\n\t"
+                  "movq %%xmm0, %0"
+                  : "=m" (*(_cells_t*) dst)
+                  : "m" (cells)
+                  : "xmm0");
+}
+
+// Puts a tile into text memory. With SSE2 that's one 8 byte store, without
+// it the compiler makes two 4 byte ones out of it. Either way it's not on 8
+// bytes, so if the card can ever read half of it is up to the CPU.
+static inline void _store_cells(uint16_t* dst, uint64_t cells)
+{
+    if (cpu_has(CPU_SSE2))
+        _store_cells_sse2(dst, cells);
+    else
+        *(_cells_t*) dst = cells;
+}
+
+static int _free_page();
+static bool _page_busy(int page);
 static void _clear();
 static void _move_cur();
 static void _scroll();
+static void _set_start(uint16_t start);
 
-void _text_init()
+static void _set_geometry(int cols, int rows, int font_height)
 {
+    text_width = cols;
+    text_height = rows;
+    // pages start on 256 characters, see _set_start
+    page_size = (cols * rows + 255) & ~255;
+    page_count = _VGA_MEMORY_SIZE / page_size;
+    if (page_count > _VGA_MAX_PAGES)
+        page_count = _VGA_MAX_PAGES;
+    // With only two pages the console keeps to the first, the game's first
+    // frame needs the other one
+    console_end = page_count < _VGA_MAX_PAGES ? page_size : _VGA_MEMORY_SIZE;
+    dash_row = rows >= 50 ? MAP_HEIGHT + 17 : 0;
+    
+    // a block cursor, as high as the font
     outb(_VGA_SELECT_REGISTER, _VGA_REGISTER_CURSORSTART);
     outb(_VGA_DATA_REGISTER, 0);
     outb(_VGA_SELECT_REGISTER, _VGA_REGISTER_CURSOREND);
-    outb(_VGA_DATA_REGISTER, 15);
-    video_mem = (uint16_t *) 0xB8000;
+    outb(_VGA_DATA_REGISTER, font_height - 1);
+}
+
+void _text_init()
+{
+    _set_geometry(80, 25, VGA_FONT_HEIGHT);
+    video_mem = _VGA_MEMORY;
+    console = true;
+    console_top = 0;
+    shown_page = 0;
+    pending_page = -1;
+    _set_start(0);
     blank = _entry(' ', attrib);
+    for (int page = 0; page < page_count; page++)
+        page_dirty[page] = _DIRTY_ALL;
+    ui_drawn = false;
+    _build_tiles();
     alternate = false;
     _clear();
 }
 
-void _text_drawfield(int data[4][4], bool lost, bool won, uint64_t score, 
-                     uint64_t highscore)
+bool _text_mode(int rows)
+{
+    // the game's screen and the graphics are made for 80x25
+    if (!console || gfx_active())
+        return false;
+    int cols = rows == 60 ? 90 : 80;
+    int font_height = vga_text_mode(cols, rows);
+    if (font_height == 0)
+        return false;
+    _set_geometry(cols, rows, font_height);
+    
+    // what the console has was for the old width, it starts over
+    console_top = 0;
+    video_mem = _VGA_MEMORY;
+    _set_start(0);
+    for (int page = 0; page < page_count; page++)
+        page_dirty[page] = _DIRTY_ALL;
+    ui_drawn = false;
+    _clear();
+    return true;
+}
+
+// where a field is in the shadow, width characters on height lines
+static void _field_rect(int field, uint16_t* loc, int* width, int* height)
+{
+    // wide enough for "Highscore: " and 20 digits, and for the longest 
+    // message and AI line
+    static const uint8_t rows[] = {1, 3, 6, 7};
+    static const uint8_t widths[] = {32, 32, 48, 48};
+    if (field < _FIELD_SCORE)
+    {
+        *loc = (1 + 2 * (field / 4)) * text_width + 1 + 5 * (field % 4);
+        *width = 4;
+        *height = 1;
+        return;
+    }
+    if (field == _FIELD_DASH)
+    {
+        *loc = (dash_row + 1) * text_width + 2;
+        *width = text_width - 2;
+        *height = 3;
+        return;
+    }
+    *loc = rows[field - _FIELD_SCORE] * text_width + _FIELD_COL;
+    *width = widths[field - _FIELD_SCORE];
+    *height = field == _FIELD_AI ? 2 : 1;
+}
+
+static void _touch(uint32_t fields)
+{
+    for (int page = 0; page < page_count; page++)
+        page_dirty[page] |= fields;
+}
+
+// blanks a text field and puts the cursor at its start, whatever's printed
+// next is its new text
+static void _begin_field(int field)
+{
+    uint16_t loc;
+    int width, height;
+    _field_rect(field, &loc, &width, &height);
+    for (int i = 0; i < height; i++)
+        for (int j = 0; j < width; j++)
+            shadow[loc + i * text_width + j] = blank;
+    cursor_x = loc % text_width;
+    cursor_y = loc / text_width;
+    _touch(1u << field);
+}
+
+// the map and all the text that never changes
+static void _draw_static()
 {
     _clear();
     char* map;
@@ -184,93 +449,459 @@ void _text_drawfield(int data[4][4], bool lost, bool won, uint64_t score,
         map = (char*) alt_map;
     else
         map = (char*) main_map;
+    shadow_map = map;
     char* buf = (char*) video_mem;
     for (int i = 0; i < MAP_HEIGHT; i++)
     {
         memcpy(buf, map + i * MAP_WIDTH, MAP_WIDTH);
-        buf = (char *) ((uint32_t) buf + _VGA_WIDTH * 2);
+        buf = (char *) ((uint32_t) buf + text_width * 2);
+    }
+    
+    cursor_x = MAP_WIDTH / 2 + 4;
+    cursor_y = 4;
+    fprintf(_screen, "!Highscores are not stored!");
+    
+    cursor_x = 0;
+    cursor_y = MAP_HEIGHT + 1;
+    fprintf(_screen, "Welcome to 2048/Arkta!\n"); // LINE 11
+    cursor_y++;                                   // LINE 12
+    fprintf(_screen, "INSTRUCTIONS:\n");          // LINE 13
+                                                  // LINE 14
+    fprintf(_screen, 
+            "Use arrow keys or WASD to move the numbers to get 2048!\n");
+    cursor_y++;                                   // LINE 15
+    fprintf(_screen, "Additional keys:\n");       // LINE 16
+    fprintf(_screen, "b B - switch between style of borders \n\
+        (fancy and basic, fancy may not be supported)\n");
+                                                  // LINE 17
+                                                  // LINE 18
+    fprintf(_screen, "r R - restart the game\n"); // LINE 19
+                                                  // LINE 20
+    fprintf(_screen, 
+            "h H - ask the AI for a hint, p P - let the AI play (autoplay)\n");
+                                                  // LINE 21
+    fprintf(_screen, 
+        "u U - undo, y Y - redo, l L - what the AI would have done instead\n");
+                                                  // LINE 22
+    fprintf(_screen, 
+            "To exit the game just press the power on/off button on your PC\n");
+    cursor_y++;                                   // LINE 23
+    fprintf(_screen, "Have fun! :D\n");           // LINE 24
+    
+    ui_cursor_x = cursor_x;
+    ui_cursor_y = cursor_y;
+    if (dash_row != 0)
+    {
+        cursor_x = 0;
+        cursor_y = dash_row;
+        fprintf(_screen, "Performance, last second (%ux%u text):", 
+                                                    text_width, text_height);
     }
+    ui_ai.shown = false;
+    ui_dash.shown = false;
+    _touch(_DIRTY_ALL);
+}
+
+void _text_drawfield(board_t board, bool lost, bool won, uint64_t score, 
+                     uint64_t highscore)
+{
+    video_mem = shadow;
+    // after the static text everything is drawn, whatever it was before
+    bool all = !ui_drawn;
+    if (all)
+        _draw_static();
+    ui_drawn = true;
     
-    buf = (char *) video_mem + 2 + _VGA_WIDTH * 2;
-    for (int x = 0; x < 4; x++)
+    shadow_tile_count = 0;
+    shadow_mask = 0;
+    for (int cell = 0; cell < 16; cell++)
     {
-        for (int y = 0; y < 4; y++)
+        int tile = board_get(board, cell);
+        uint16_t loc;
+        int width, height;
+        _field_rect(cell, &loc, &width, &height);
+        if (all || tile != board_get(ui_board, cell))
         {
-            if (data[x][y] != 0)
-            {
-                memcpy(buf, text + data[x][y] - 1, 8);
-            }
-            buf += 10;
+            // an empty cell is 4 blanks, same as the map there
+            *(_cells_t*) (shadow + loc) = _tile_cells(tile);
+            _touch(1u << cell);
         }
-        buf += _VGA_WIDTH * 4 - 40;
+        if (tile != 0)
+        {
+            shadow_tiles[shadow_tile_count] = loc;
+            shadow_values[shadow_tile_count++] = tile;
+            shadow_mask |= 1u << cell;
+        }
+    }
+    ui_board = board;
+    
+    if (all || score != ui_score)
+    {
+        _begin_field(_FIELD_SCORE);
+        fprintf(_screen, "Score: %M", score);
+        ui_score = score;
+    }
+    if (all || highscore != ui_highscore)
+    {
+        _begin_field(_FIELD_HIGH);
+        fprintf(_screen, "Highscore: %M", highscore);
+        ui_highscore = highscore;
+    }
+    
+    int status = won ? 1 : lost ? 2 : 0;
+    if (all || status != ui_status)
+    {
+        _begin_field(_FIELD_STATUS);
+        if (won)
+            fprintf(_screen, "You won the game! Congratulations! :D");
+        else if (lost)
+            fprintf(_screen, "You lost the game! Better luck next time! :(");
+        ui_status = status;
     }
     
-    cursor_x = MAP_WIDTH / 2 + 2;       // COL 44
-    cursor_y = 1;
-    // print score
-    printf("Score: %M", score);
+    cursor_x = ui_cursor_x;
+    cursor_y = ui_cursor_y;
+}
+
+void _text_drawai(const char* name, int dir, int depth, uint32_t nodes, 
+                  uint32_t us, bool autoplay)
+{
+    static const char* names[DIR_COUNT] = {"Up", "Down", "Left", "Right"};
+    
+    ui_ai.drawn = true;
+    if (ui_ai.shown && ui_ai.name == name && ui_ai.dir == dir && 
+        ui_ai.depth == depth && ui_ai.nodes == nodes && ui_ai.us == us && 
+        ui_ai.autoplay == autoplay)
+        return;
+    ui_ai.shown = true;
+    ui_ai.name = name;
+    ui_ai.dir = dir;
+    ui_ai.depth = depth;
+    ui_ai.nodes = nodes;
+    ui_ai.us = us;
+    ui_ai.autoplay = autoplay;
     
-    cursor_x = MAP_WIDTH / 2 + 2;
-    cursor_y = 3;
-    printf("Highscore: %M", highscore);
+    _begin_field(_FIELD_AI);
+    if (dir < 0)
+        fprintf(_screen, "%s: no moves left", name);
+    else
+        fprintf(_screen, "%s: %s", name, names[dir]);
+    if (autoplay)
+        fprintf(_screen, ", autoplay is on");
     
-    cursor_x = MAP_WIDTH / 2 + 4;
-    cursor_y = 4;
-    printf("!Highscores are not stored!");
+    if (dir >= 0)
+    {
+        cursor_x = _FIELD_COL;
+        cursor_y++;
+        fprintf(_screen, "depth %d, %u nodes, %u us", depth, nodes, us);
+    }
+    cursor_x = ui_cursor_x;
+    cursor_y = ui_cursor_y;
+}
+
+void _text_drawdash(uint32_t fps, uint32_t moves, uint32_t nodes, 
+                    uint32_t cells)
+{
+    if (dash_row == 0 || (ui_dash.shown && ui_dash.fps == fps && 
+        ui_dash.moves == moves && ui_dash.nodes == nodes && 
+        ui_dash.cells == cells))
+        return;
+    ui_dash.shown = true;
+    ui_dash.fps = fps;
+    ui_dash.moves = moves;
+    ui_dash.nodes = nodes;
+    ui_dash.cells = cells;
     
-    if (won)
+    _begin_field(_FIELD_DASH);
+    fprintf(_screen, "%u frames, %u characters copied to the screen each", 
+                                                                fps, cells);
+    cursor_x = 2;
+    cursor_y++;
+    fprintf(_screen, "%u moves", moves);
+    cursor_x = 2;
+    cursor_y++;
+    fprintf(_screen, "%u AI nodes searched", nodes);
+    cursor_x = ui_cursor_x;
+    cursor_y = ui_cursor_y;
+}
+
+uint32_t _text_copied()
+{
+    uint32_t count = copied;
+    copied = 0;
+    return count;
+}
+
+// the AI's lines stay until a frame comes without them
+static void _end_frame()
+{
+    if (ui_ai.shown && !ui_ai.drawn)
     {
-        cursor_x = MAP_WIDTH / 2 + 2;
-        cursor_y = 6;
-        printf("You won the game! Congratulations! :D");
+        _begin_field(_FIELD_AI);
+        ui_ai.shown = false;
+        cursor_x = ui_cursor_x;
+        cursor_y = ui_cursor_y;
     }
-    else if (lost)
+    ui_ai.drawn = false;
+}
+
+// brings a page up to the shadow, only the fields it doesn't have yet and
+// the tiles slides put on it are copied
+static void _sync_page(int page)
+{
+    uint16_t* mem = _VGA_MEMORY + page * page_size;
+    uint32_t dirty = page_dirty[page];
+    page_dirty[page] = 0;
+    if (dirty & _DIRTY_ALL)
     {
-        cursor_x = MAP_WIDTH / 2 + 2;
-        cursor_y = 6;
-        printf("You lost the game! Better luck next time! :(");
+        memcpy(mem, shadow, text_width * text_height * 2);
+        copied += text_width * text_height;
+        page_tile_count[page] = 0;
+        return;
     }
     
-    cursor_x = 0;
-    cursor_y = MAP_HEIGHT + 1;
+    for (int i = 0; i < page_tile_count[page]; i++)
+    {
+        uint16_t loc = page_tiles[page][i];
+        _store_cells(mem + loc, *(_cells_t*) (shadow + loc));
+    }
+    copied += page_tile_count[page] * 4;
+    page_tile_count[page] = 0;
+    
+    for (int field = 0; dirty != 0; field++, dirty >>= 1)
+    {
+        if (!(dirty & 1))
+            continue;
+        uint16_t loc;
+        int width, height;
+        _field_rect(field, &loc, &width, &height);
+        copied += width * height;
+        if (field < _FIELD_SCORE)
+        {
+            _store_cells(mem + loc, *(_cells_t*) (shadow + loc));
+            continue;
+        }
+        for (int i = 0; i < height; i++, loc += text_width)
+            memcpy(mem + loc, shadow + loc, width * 2);
+    }
+}
+
+void _text_beginslide()
+{
+    if (gfx_active())
+    {
+        slide_tile_count = 0;
+        sliding = true;
+        return;
+    }
+    int page = _free_page();
+    video_mem = _VGA_MEMORY + page * page_size;
+    _sync_page(page);
+    
+    // put the grid back where the tiles were, the rest stays. Those cells
+    // come back from the shadow with the next full frame on this page.
+    for (int i = 0; i < shadow_tile_count; i++)
+    {
+        uint16_t loc = shadow_tiles[i];
+        memcpy(video_mem + loc, shadow_map + (loc / text_width) * MAP_WIDTH + 
+                                            (loc % text_width) * 2, 8);
+    }
+    copied += shadow_tile_count * 4;
+    page_dirty[page] |= shadow_mask;
+}
+
+void _text_drawtile(int row, int col, int tile)
+{
+    if (tile <= 0 || tile > _TILE_MAX || row < 1 || row >= MAP_HEIGHT - 1 || 
+                                        col < 1 || col > MAP_WIDTH / 2 - 5)
+        return;
+    if (gfx_active())
+    {
+        if (sliding && slide_tile_count < 16)
+        {
+            gfx_tile_t* slide = &slide_tiles[slide_tile_count++];
+            slide->row = row;
+            slide->col = col;
+            slide->tile = tile;
+        }
+        return;
+    }
+    int page = (video_mem - _VGA_MEMORY) / page_size;
+    if (video_mem == shadow || page_tile_count[page] == 16)
+        return;
+    uint16_t loc = row * text_width + col;
+    _store_cells(video_mem + loc, _tile_cells(tile));
+    page_tiles[page][page_tile_count[page]++] = loc;
+    copied += 4;
+}
+
+// waits for the start of a vertical retrace, not just for being in one
+static void _wait_retrace()
+{
+    uint64_t start = tsc_read();
+    uint64_t timeout = tsc_from_us(_VGA_RETRACE_TIMEOUT_US);
+    while ((inb(_VGA_INPUT_STATUS) & _VGA_STATUS_RETRACE) &&
+                                            tsc_read() - start < timeout);
+    while (!(inb(_VGA_INPUT_STATUS) & _VGA_STATUS_RETRACE) &&
+                                            tsc_read() - start < timeout);
+}
+
+uint32_t _text_refresh_init()
+{
+    _wait_retrace();
+    uint64_t start = tsc_read();
+    for (int i = 0; i < 4; i++)
+        _wait_retrace();
+    uint64_t frame = (tsc_read() - start) / 4;
+    if (frame == 0)
+        return 0;
+    // a flip this old has been through a retrace for sure
+    frame_ticks = frame + frame / 8;
+    return (uint32_t) (tsc_from_us(1000000) / frame);
+}
+
+static bool _page_busy(int page)
+{
+    if (console)
+        return page * page_size < console_top + text_width * text_height &&
+                                (page + 1) * page_size > console_top;
+    return page == shown_page || page == pending_page;
+}
+
+// a page that's neither on the screen nor about to be
+static int _free_page()
+{
+    for (int page = 0; page < page_count; page++)
+        if (!_page_busy(page))
+            return page;
+    // With two pages there's none while a flip is pending. After the next
+    // retrace the one that was shown is free.
+    int page = shown_page;
+    _wait_retrace();
+    shown_page = pending_page;
+    pending_page = -1;
+    return page;
+}
+
+// a flip from less than a frame ago may not have been taken yet
+static bool _flip_pending()
+{
+    return pending_page >= 0 && (frame_ticks == 0 || 
+                                        tsc_read() - flip_tsc < frame_ticks);
+}
+
+bool _text_ready()
+{
+    return gfx_active() || !_flip_pending();
+}
+
+bool _text_graphics()
+{
+    // it takes the 80x25 screen and the 8x16 font
+    if (text_height != 25 || !gfx_init())
+        return false;
+    // nothing in text memory is seen anymore, printf goes to the shadow too
+    console = false;
+    video_mem = shadow;
+    pending_page = -1;
+    sliding = false;
+    return true;
+}
+
+// the tiles of the last full frame, or of the slide if there's one
+static void _gfx_present()
+{
+    if (!sliding)
+    {
+        _end_frame();
+        for (int i = 0; i < shadow_tile_count; i++)
+        {
+            slide_tiles[i].row = shadow_tiles[i] / text_width;
+            slide_tiles[i].col = shadow_tiles[i] % text_width;
+            slide_tiles[i].tile = shadow_values[i];
+        }
+        slide_tile_count = shadow_tile_count;
+    }
+    gfx_present(shadow, slide_tiles, slide_tile_count);
+    sliding = false;
+}
+
+void _text_present()
+{
+    if (gfx_active())
+    {
+        _gfx_present();
+        return;
+    }
+    if (video_mem == shadow)
+    {
+        _end_frame();
+        int page = _free_page();
+        video_mem = _VGA_MEMORY + page * page_size;
+        _sync_page(page);
+    }
+    else if (console && video_mem - _VGA_MEMORY == console_top)
+        return;
+    int page = (video_mem - _VGA_MEMORY) / page_size;
+    if (_page_busy(page))
+        return;
+    
+    _set_start(page * page_size);
+    // the console's screen can be over two pages, the first frame waits so
+    // the game has all three
+    if (_flip_pending() || console)
+    {
+        // Two flips in one frame, either of the older pages can still be on
+        // the screen. After the retrace it's this one for sure.
+        _wait_retrace();
+        console = false;
+        shown_page = page;
+        pending_page = -1;
+    }
+    else
+    {
+        if (pending_page >= 0)
+            shown_page = pending_page;
+        pending_page = page;
+        flip_tsc = tsc_read();
+    }
     _move_cur();
-    printf("Welcome to 2048/Arkta!\n"); // LINE 11
-    cursor_y++;                         // LINE 12
-    printf("INSTRUCTIONS:\n");          // LINE 13
-                                        // LINE 14
-    printf("Use arrow keys or WASD to move the numbers to get 2048!\n");
-    cursor_y++;                         // LINE 15
-    printf("Additional keys:\n");       // LINE 16
-    printf("b B - switch between style of borders \n\
-        (fancy and basic, fancy may not be supported)\n");
-                                        // LINE 17
-                                        // LINE 18
-    printf("r R - restart the game\n"); // LINE 19
-    cursor_y++;                         // LINE 20
-                                        // LINE 21
-    printf("To exit the game just press the power on/off button on your PC\n");
-    cursor_y++;                         // LINE 22
-    cursor_y++;                         // LINE 23
-    printf("Have fun! :D\n");           // LINE 24
 }
 
 void _text_switchstyle()
 {
     alternate = !alternate;
+    ui_drawn = false;
 }
 
 static void _clear()
 {
-    for(size_t i = 0; i < _VGA_WIDTH * _VGA_HEIGHT; i++)
+    for(size_t i = 0; i < text_width * text_height; i++)
         video_mem[i] = blank;
     cursor_x = 0;
     cursor_y = 0;
     _move_cur();
 }
 
+// Pages are a multiple of 256 characters apart so only the high byte ever
+// changes, the CRTC can't take half of a new address. The console's lines
+// aren't, worst case that's one frame from the wrong place.
+static void _set_start(uint16_t start)
+{
+    outb(_VGA_SELECT_REGISTER, _VGA_REGISTER_STARTHIGH);
+    outb(_VGA_DATA_REGISTER, start >> 8);
+    outb(_VGA_SELECT_REGISTER, _VGA_REGISTER_STARTLOW);
+    outb(_VGA_DATA_REGISTER, start & 0xFF);
+}
+
+// the cursor is on the page that's drawn into, so it's only seen when that
+// page is. The shadow gets it once it's copied to one.
 static void _move_cur()
 {
-    uint16_t loc = cursor_y * 80 + cursor_x;
+    if (video_mem == shadow)
+        return;
+    uint16_t loc = (video_mem - _VGA_MEMORY) + cursor_y * text_width + 
+                                                                    cursor_x;
     outb(_VGA_SELECT_REGISTER, _VGA_REGISTER_CURSORLOCHIGH);
     outb(_VGA_DATA_REGISTER, loc >> 8);
     outb(_VGA_SELECT_REGISTER, _VGA_REGISTER_CURSORLOCLOW);
@@ -279,29 +910,65 @@ static void _move_cur()
 
 static void _scroll()
 {
-    if(cursor_y >= 25)
+    if(cursor_y < text_height)
+        return;
+    uint16_t lines = cursor_y - (text_height - 1);
+    uint16_t keep = text_width * (text_height - lines);
+    
+    if(!console)
     {
-        memmove(video_mem, video_mem + _VGA_WIDTH * (cursor_y - 24),\
-                            _VGA_WIDTH * (_VGA_HEIGHT - (cursor_y - 24)) * 2);
-        for(size_t i = _VGA_WIDTH * (_VGA_HEIGHT - (cursor_y - 24));\
-                                            i < _VGA_WIDTH * _VGA_HEIGHT; i++)
-            video_mem[i] = blank;
-        cursor_y = 24;
+        // a page can't move, it's memmove like before
+        memmove(video_mem, video_mem + text_width * lines, keep * 2);
     }
+    else if(console_top + text_width * (text_height + lines) <= console_end)
+    {
+        console_top += text_width * lines;
+        video_mem = _VGA_MEMORY + console_top;
+    }
+    else
+    {
+        // off the end, the lines that stay go back to the start
+        memcpy(_VGA_MEMORY, video_mem + text_width * lines, keep * 2);
+        console_top = 0;
+        video_mem = _VGA_MEMORY;
+    }
+    
+    for(size_t i = keep; i < text_width * text_height; i++)
+        video_mem[i] = blank;
+    if(console)
+        _set_start(console_top);
+    cursor_y = text_height - 1;
 }
 
 // __kernel__
 #endif
 
+FILE _stdout = {_STREAM_VGA | _STREAM_SERIAL};
+FILE _stderr = {_STREAM_VGA | _STREAM_SERIAL};
+FILE _stdscreen = {_STREAM_VGA};
+
 // TODO errno.h
 int fputc(int c, FILE *stream)
 {
 #ifdef __kernel__
-    if(stream != stdout)
+    if(stream == 0)
         return EOF;
     
+    if(stream->targets & _STREAM_SERIAL)
+    {
+        if(c == '\n')
+            serial_putc('\r');
+        serial_putc(c);
+    }
+    if(!(stream->targets & _STREAM_VGA))
+        return c;
+    
+    // a page written to directly gets all of the shadow again next time
+    if(!console && video_mem != shadow)
+        page_dirty[(video_mem - _VGA_MEMORY) / page_size] = _DIRTY_ALL;
+    
     uint16_t entr = _entry((uint8_t) c, attrib);
-    uint16_t loc = cursor_y * _VGA_WIDTH + cursor_x;
+    uint16_t loc = cursor_y * text_width + cursor_x;
     
     if(c == '\b' && cursor_x != 0) // Backspace
     {
@@ -335,7 +1002,7 @@ int fputc(int c, FILE *stream)
         cursor_x++;
     }
     
-    if(cursor_x >= 80)
+    if(cursor_x >= text_width)
     {
         cursor_x = 0;
         cursor_y++;
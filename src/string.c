@@ -27,6 +27,8 @@
 *******************************************************************************/
 
 #include <stddef.h>
+#include <stdint.h>
+#include "cpu.h"
 #include "string.h"
 
 static inline size_t min(size_t a, size_t b)
@@ -36,12 +38,56 @@ static inline size_t min(size_t a, size_t b)
     return b;
 }
 
-void *memcpy(void *restrict s1, const void *restrict s2, size_t n)
+// Forward copies, so memmove can use them when the destination is lower.
+// Plain bytes until _string_init, since that's all that works everywhere.
+typedef void (*copy_f)(unsigned char *dst, const unsigned char *src, size_t n);
+
+static void copy_bytes(unsigned char *dst, const unsigned char *src, size_t n)
 {
-    unsigned char *buf1 = (unsigned char *) s1;
-    const unsigned char *buf2 = (const unsigned char *) s2;
     for(size_t i = 0; i < n; i++)
-        buf1[i] = buf2[i];
+        dst[i] = src[i];
+}
+
+static void copy_movs(unsigned char *dst, const unsigned char *src, size_t n)
+{
+    size_t words = n / 4;
+    asm volatile("cld; rep movsl"
+                 : "+D" (dst), "+S" (src), "+c" (words)
+                 :
+                 : "memory");
+    copy_bytes(dst, src, n % 4);
+}
+
+typedef char v16 __attribute__((vector_size(16)));
+
+// 64 bytes a round, loads before stores so it still works as a forward move
+__attribute__((target("sse2")))
+static void copy_sse2(unsigned char *dst, const unsigned char *src, size_t n)
+{
+    for(; n >= 64; n -= 64, dst += 64, src += 64)
+    {
+        v16 a = __builtin_ia32_loaddqu((const char *) src);
+        v16 b = __builtin_ia32_loaddqu((const char *) src + 16);
+        v16 c = __builtin_ia32_loaddqu((const char *) src + 32);
+        v16 d = __builtin_ia32_loaddqu((const char *) src + 48);
+        __builtin_ia32_storedqu((char *) dst, a);
+        __builtin_ia32_storedqu((char *) dst + 16, b);
+        __builtin_ia32_storedqu((char *) dst + 32, c);
+        __builtin_ia32_storedqu((char *) dst + 48, d);
+    }
+    copy_movs(dst, src, n);
+}
+
+static copy_f copy = copy_bytes;
+
+void _string_init()
+{
+    copy = cpu_has(CPU_SSE2) ? copy_sse2 : copy_movs;
+}
+
+void *memcpy(void *restrict s1, const void *restrict s2, size_t n)
+{
+    copy((unsigned char *) s1, (const unsigned char *) s2, n);
     return s1;
 }
 
@@ -50,8 +96,7 @@ void *memmove(void *s1, const void *s2, size_t n)
     unsigned char *buf1 = (unsigned char *) s1;
     const unsigned char *buf2 = (unsigned char *) s2;
     if(buf1 < buf2)
-        for(size_t i = 0; i < n; i++)
-            buf1[i] = buf2[i];
+        copy(buf1, buf2, n);
     else if(buf1 > buf2)
         for(size_t i = n; i > 0; i--)
             buf1[i - 1] = buf2[i - 1];
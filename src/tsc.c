@@ -0,0 +1,101 @@
+//
+// tsc.c - implementation of tsc.h
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#include <stdint.h>
+
+#include "tsc.h"
+
+#ifdef __kernel__
+
+#include "ports.h"
+
+#define CALIBRATE_MS    10
+
+static uint32_t per_us = 1;
+
+void tsc_init()
+{
+    // channel 2 counts down once in mode 0 and raises its output at 0,
+    // speaker stays off
+    uint8_t port_b = inb(_PS2_KB_CONTROLLER_PORT_B);
+    port_b &= ~(_PS2_SPEAKER_DATA_ENABLE | _PIT_CHAN2_GATE_ENABLE);
+    outb(_PS2_KB_CONTROLLER_PORT_B, port_b);
+    
+    uint16_t count = _PIT_FREQUENCY / 1000 * CALIBRATE_MS;
+    outb(_PIT_COMMAND_REGISTER, _PIT_SELECT_CHAN2 | _PIT_ACCESS_BOTH | 
+                                                    _PIT_INTERRUPT_ON_COUNT);
+    outb(_PIT_CHANNEL2_DATA, count & 0xFF);
+    outb(_PIT_CHANNEL2_DATA, count >> 8);
+    
+    // the gate going up starts the count
+    outb(_PS2_KB_CONTROLLER_PORT_B, port_b | _PIT_CHAN2_GATE_ENABLE);
+    uint64_t start = tsc_read();
+    while (!(inb(_PS2_KB_CONTROLLER_PORT_B) & _PIT_CHAN2_OUTPUT));
+    uint64_t end = tsc_read();
+    outb(_PS2_KB_CONTROLLER_PORT_B, port_b);
+    
+    per_us = (uint32_t) ((end - start) / (CALIBRATE_MS * 1000));
+    if (per_us == 0)
+        per_us = 1;
+}
+
+#else
+
+#include <time.h>
+
+#define CALIBRATE_NS    20000000
+
+static uint32_t per_us = 1;
+
+static uint64_t ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void tsc_init()
+{
+    uint64_t start_ns = ns();
+    uint64_t start = tsc_read();
+    uint64_t now;
+    while ((now = ns()) - start_ns < CALIBRATE_NS);
+    uint64_t end = tsc_read();
+    
+    per_us = (uint32_t) ((end - start) * 1000 / (now - start_ns));
+    if (per_us == 0)
+        per_us = 1;
+}
+
+// __kernel__
+#endif
+
+uint32_t tsc_per_us()
+{
+    return per_us;
+}
@@ -0,0 +1,186 @@
+//
+// vga.c - text modes and the font of the VGA
+//
+
+/*******************************************************************************
+* MIT License                                                                  *
+*                                                                              *
+* Copyright (c) 2017 Uko Kokņevičs (Uko Koknevics)                             *
+*                                                                              *
+* Permission is hereby granted, free of charge, to any person obtaining a copy *
+* of this software and associated documentation files (the "Software"), to     *
+* deal in the Software without restriction, including without limitation the   *
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or  *
+* sell copies of the Software, and to permit persons to whom the Software is   *
+* furnished to do so, subject to the following conditions:                     *
+*                                                                              *
+* The above copyright notice and this permission notice shall be included in   *
+* all copies or substantial portions of the Software.                          *
+*                                                                              *
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR   *
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,     *
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE  *
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER       *
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      *
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS *
+* IN THE SOFTWARE.                                                             *
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ports.h"
+#include "vga.h"
+
+// The timing of a 90x60 mode: 8 dot characters at 28 MHz like 80x25 at 9 
+// dots make 720 dots a line, and the 480 lines of 640x480 at 8 lines a 
+// character make 60 rows.
+static const uint8_t crtc_90x60[][2] = {
+    {0x00, 0x6B},   // horizontal total, 112 characters
+    {0x01, 0x59},   // displayed, 90
+    {0x02, 0x5A},   // blanking
+    {0x03, 0x82},
+    {0x04, 0x60},   // retrace
+    {0x05, 0x8D},
+    {0x06, 0x0B},   // vertical total, 525 lines
+    {0x07, 0x3E},   // the 9th and 10th bits of the vertical ones
+    {0x10, 0xEA},   // retrace
+    {0x12, 0xDF},   // displayed, 480
+    {0x13, 0x2D},   // a row is 45 words
+    {0x15, 0xE7},   // blanking
+    {0x16, 0x04},
+};
+
+static uint8_t saved_regs[5];
+
+// In text mode plane 2 is hidden behind the odd/even addressing of the 
+// characters. The sequencer and graphics controller have to be told to let
+// it be reached linearly for a moment.
+static volatile uint8_t* font_begin()
+{
+    outb(_VGA_SEQ_SELECT_REGISTER, _VGA_SEQ_MAP_MASK);
+    saved_regs[0] = inb(_VGA_SEQ_DATA_REGISTER);
+    outb(_VGA_SEQ_SELECT_REGISTER, _VGA_SEQ_MEMORY_MODE);
+    saved_regs[1] = inb(_VGA_SEQ_DATA_REGISTER);
+    outb(_VGA_GC_SELECT_REGISTER, _VGA_GC_READ_MAP);
+    saved_regs[2] = inb(_VGA_GC_DATA_REGISTER);
+    outb(_VGA_GC_SELECT_REGISTER, _VGA_GC_MODE);
+    saved_regs[3] = inb(_VGA_GC_DATA_REGISTER);
+    outb(_VGA_GC_SELECT_REGISTER, _VGA_GC_MISC);
+    saved_regs[4] = inb(_VGA_GC_DATA_REGISTER);
+    
+    outb(_VGA_SEQ_SELECT_REGISTER, _VGA_SEQ_MAP_MASK);
+    outb(_VGA_SEQ_DATA_REGISTER, 0x04);
+    outb(_VGA_SEQ_SELECT_REGISTER, _VGA_SEQ_MEMORY_MODE);
+    outb(_VGA_SEQ_DATA_REGISTER, 0x07);
+    outb(_VGA_GC_SELECT_REGISTER, _VGA_GC_READ_MAP);
+    outb(_VGA_GC_DATA_REGISTER, 0x02);
+    outb(_VGA_GC_SELECT_REGISTER, _VGA_GC_MODE);
+    outb(_VGA_GC_DATA_REGISTER, 0x00);
+    outb(_VGA_GC_SELECT_REGISTER, _VGA_GC_MISC);
+    outb(_VGA_GC_DATA_REGISTER, 0x04);
+    return (volatile uint8_t*) 0xA0000;
+}
+
+static void font_end()
+{
+    outb(_VGA_SEQ_SELECT_REGISTER, _VGA_SEQ_MAP_MASK);
+    outb(_VGA_SEQ_DATA_REGISTER, saved_regs[0]);
+    outb(_VGA_SEQ_SELECT_REGISTER, _VGA_SEQ_MEMORY_MODE);
+    outb(_VGA_SEQ_DATA_REGISTER, saved_regs[1]);
+    outb(_VGA_GC_SELECT_REGISTER, _VGA_GC_READ_MAP);
+    outb(_VGA_GC_DATA_REGISTER, saved_regs[2]);
+    outb(_VGA_GC_SELECT_REGISTER, _VGA_GC_MODE);
+    outb(_VGA_GC_DATA_REGISTER, saved_regs[3]);
+    outb(_VGA_GC_SELECT_REGISTER, _VGA_GC_MISC);
+    outb(_VGA_GC_DATA_REGISTER, saved_regs[4]);
+}
+
+// every character has 32 lines of room in the plane, whatever it uses
+void vga_read_font(uint8_t* glyphs, int height)
+{
+    volatile uint8_t* plane = font_begin();
+    for (int c = 0; c < 256; c++)
+        for (int row = 0; row < height; row++)
+            glyphs[c * height + row] = plane[c * 32 + row];
+    font_end();
+}
+
+void vga_write_font(const uint8_t* glyphs, int height)
+{
+    volatile uint8_t* plane = font_begin();
+    for (int c = 0; c < 256; c++)
+        for (int row = 0; row < 32; row++)
+            plane[c * 32 + row] = row < height ? glyphs[c * height + row] : 0;
+    font_end();
+}
+
+// Two lines of the big font make one of the small one. Or'ing them keeps 
+// every line that was there, only the gaps of the double lines in the 
+// borders get lost, those turn into thick ones.
+static void load_small_font()
+{
+    static uint8_t big[256 * VGA_FONT_HEIGHT];
+    static uint8_t small[256 * VGA_FONT_HEIGHT / 2];
+    vga_read_font(big, VGA_FONT_HEIGHT);
+    for (int i = 0; i < 256 * VGA_FONT_HEIGHT / 2; i++)
+        small[i] = big[i * 2] | big[i * 2 + 1];
+    vga_write_font(small, VGA_FONT_HEIGHT / 2);
+}
+
+static void crtc_write(uint8_t index, uint8_t value)
+{
+    outb(_VGA_SELECT_REGISTER, index);
+    outb(_VGA_DATA_REGISTER, value);
+}
+
+static uint8_t crtc_read(uint8_t index)
+{
+    outb(_VGA_SELECT_REGISTER, index);
+    return inb(_VGA_DATA_REGISTER);
+}
+
+int vga_text_mode(int cols, int rows)
+{
+    if (cols == 80 && rows == 25)
+        return VGA_FONT_HEIGHT;
+    if (!(cols == 80 && rows == 50) && !(cols == 90 && rows == 60))
+        return 0;
+    
+    if (cols == 90)
+    {
+        // the clock and the polarities can only change with the sequencer
+        // held in reset
+        outb(_VGA_SEQ_SELECT_REGISTER, _VGA_SEQ_RESET);
+        outb(_VGA_SEQ_DATA_REGISTER, _VGA_SEQ_RESET_SYNC);
+        uint8_t misc = inb(_VGA_MISC_READ) & ~_VGA_MISC_SYNC_MASK;
+        outb(_VGA_MISC_WRITE, misc | _VGA_MISC_SYNC_480);
+        outb(_VGA_SEQ_SELECT_REGISTER, _VGA_SEQ_CLOCKING);
+        uint8_t clocking = inb(_VGA_SEQ_DATA_REGISTER);
+        outb(_VGA_SEQ_DATA_REGISTER, clocking | _VGA_SEQ_CLOCKING_8DOT);
+        outb(_VGA_SEQ_SELECT_REGISTER, _VGA_SEQ_RESET);
+        outb(_VGA_SEQ_DATA_REGISTER, _VGA_SEQ_RESET_RUN);
+        
+        // the vertical retrace end register also locks the first 8
+        crtc_write(_VGA_REGISTER_VRETRACE_END, 
+            crtc_read(_VGA_REGISTER_VRETRACE_END) & ~_VGA_DATA_PROTECT);
+        for (size_t i = 0; i < sizeof(crtc_90x60) / sizeof(crtc_90x60[0]); 
+                                                                        i++)
+            crtc_write(crtc_90x60[i][0], crtc_90x60[i][1]);
+        crtc_write(_VGA_REGISTER_VRETRACE_END, 0x0C | _VGA_DATA_PROTECT);
+        
+        // 9 dot characters are panned by one more dot, 8 dot ones aren't
+        inb(_VGA_INPUT_STATUS);
+        outb(_VGA_ATTR_REGISTER, _VGA_ATTR_PANNING | _VGA_ATTR_KEEP_VIDEO);
+        outb(_VGA_ATTR_REGISTER, 0);
+    }
+    
+    // 400 or 480 lines, 8 a character
+    uint8_t maxscan = crtc_read(_VGA_REGISTER_MAXSCAN) & ~0x1F;
+    if (cols == 90)
+        maxscan = 0x40;     // and the 10th bit of the line compare
+    crtc_write(_VGA_REGISTER_MAXSCAN, maxscan | (VGA_FONT_HEIGHT / 2 - 1));
+    load_small_font();
+    return VGA_FONT_HEIGHT / 2;
+}
@@ -31,6 +31,10 @@
 mkdir -p isodir/boot/grub
 cp grub.cfg isodir/boot/grub/grub.cfg
 cp kernel isodir/kernel
+# n-tuple weights for the AI, optional, see README
+[ -f weights.ntw ] && cp weights.ntw isodir/weights.ntw
+# replays to check at boot, optional too
+[ -f replays.rpl ] && cp replays.rpl isodir/replays.rpl
 # cp libc/libc.a isodir/libc.a
 grub-mkrescue -o arkta.iso --product-name="2048/Arkta" isodir
 rm -r isodir